@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <stdlib.h>  
 #include <algorithm>
+#include "ds_small_vector.h"
 
 using namespace std;
 
@@ -13,9 +14,10 @@ namespace contains_duplicate_II {
 	class Solution {
 	public:
 		bool containsNearbyDuplicate(vector<int>& nums, int k) {
-			unordered_map<int, vector<int>> mp{};
+			//Most numbers occur once or twice, SmallVector keeps their indices inside the map node instead of a separate allocation.
+			unordered_map<int, ds_small_vector::SmallVector<int, 4>> mp{};
 			for (int i = 0; i < nums.size(); i++) {
-				auto ret = mp.insert({ nums[i], vector<int>{i} });//Insert returns std::pair<iterator,bool>. Bool tells if the element was inserted or not and the iterator is the pointer to the map element pair (in our specific case, int, vector<int>)
+				auto ret = mp.insert({ nums[i], ds_small_vector::SmallVector<int, 4>{i} });//Insert returns std::pair<iterator,bool>. Bool tells if the element was inserted or not and the iterator is the pointer to the map element pair (in our specific case, int, vector<int>)
 				if (!ret.second){//If the element already exists
 					//Oh man I hate STD interface designers. Look at the following shit.
 					//We already know abt ret from above. First refers to the std::pair<int,vector<int>> (element of the map). Then we access the second within the second pair, which is the list of stored indices. Finally, loop over the list and compare it with the current index to check the condition for k.
@@ -7,11 +7,27 @@
 #include "templates_basics.h"
 #include "dp_decorator_dynamic.h"
 #include "dp_decorator_static.h"
+#include "dp_decorator_any_shape.h"
+#include "dp_decorator_constexpr.h"
+#include "templates_minmax.h"
+#include "templates_approx_equal.h"
+#include "concurrency_thread_pool.h"
+#include "SFINAE.h"
 #include "CRTP.h"
 #include "testing.h"
 #include "dp_SOLID_OCP.h"
+#include "dp_SOLID_query_planner.h"
+#include "dp_SOLID_materialized_view.h"
+#include "dp_SOLID_batch_filter.h"
+#include "dp_SOLID_spec_compiler.h"
+#include "dp_SOLID_product_catalog.h"
+#include "dp_SOLID_catalog_loader.h"
+#include "dp_SOLID_name_index.h"
 #include "versions_cpp_20.h"
 #include "ds_linked_list.h"
+#include "ds_poly_collection.h"
+#include "ds_small_vector.h"
+#include "basic_concepts_dispatch_benchmark.h"
 #include "217_Contains_Duplicate.h"
 #include "219_Contains_Duplicate_II.h"
 
@@ -19,12 +35,28 @@ int main()
 {
 //	dp_decorator_dynamic::main();
 //	db_decorator_static::main();
+//	dp_decorator_any_shape::main();
+//	dp_decorator_constexpr::main();
+//	templates_minmax::main();
+//	templates_approx_equal::main();
+//	concurrency_thread_pool::main();
+//	sfinae_binary_reader::main();
 //	temp_crtp_1::main();
 //	temp_crtp::main();
+//	ds_poly_collection::main();
+//	ds_small_vector::main();
+//	basic_concepts_dispatch_benchmark::main();
 //	temp_testing::main();
 //	temp_testing2::main();
 
 //	dp_SOLID_Specification::main();
+//	dp_SOLID_query_planner::main();
+//	dp_SOLID_materialized_view::main();
+//	dp_SOLID_batch_filter::main();
+//	dp_SOLID_spec_compiler::main();
+//	dp_SOLID_product_catalog::main();
+//	dp_SOLID_catalog_loader::main();
+//	dp_SOLID_name_index::main();
 
 //	std::vector<int> vals{ 1,2,3,4,5 };
 	//std::vector<ds_linked_list::MyType> vals{ {"Str1", 1}, {"Str2", 2}, {"Str3", 3}, {"Str4", 4}, {"Str5", 5} };
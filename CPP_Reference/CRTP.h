@@ -1,6 +1,12 @@
 #pragma once
+#include <new>
+#include <span>
+#include <chrono>
+#include <memory>
 #include <vector>
+#include <utility>
 #include <iostream>
+#include "ds_arena.h"
 
 //One of the most frequent uses for CRTP is Compile Time Polymorphism.
 //The speciality of CRTP is that the derived calss derives from the base class but passes itself as the template argument.
@@ -42,15 +48,42 @@ namespace temp_crtp_1 {
 
 
 // https://www.youtube.com/watch?v=7-nHdQjSRe0
+//Clone() returns a raw new'ed copy that the caller has to delete (and main() below used to leak it). The other cloning functions return
+//owners instead:
+//	clone()			- std::unique_ptr<Shape>, one heap allocation per copy.
+//	clone(arena)	- the copy lives in a ds_arena::MonotonicArena, the ArenaPtr only runs the destructor, the memory goes with the arena.
+//	clone_all(shapes) - snapshots a whole scene into one Scene: all copies are placed next to each other in a few large arena blocks.
+//	  Destroying the Scene runs the destructor of every copy and frees the blocks. Shape has a virtual destructor, so no shape is
+//	  trivially destructible and there is nothing that could be skipped safely.
 namespace temp_crtp {
+	struct Shape;
+
+	struct ArenaDeleter {
+		void operator()(Shape* shape) const noexcept;
+	};
+
+	using ArenaPtr = std::unique_ptr<Shape, ArenaDeleter>;
+
 	struct Shape {
 		virtual Shape* Clone() = 0;
+		virtual std::unique_ptr<Shape> clone() const = 0;
+		virtual Shape* clone_into(ds_arena::MonotonicArena& arena) const = 0;	//The caller is responsible for the destructor
 		virtual ~Shape() = default;
+
+		ArenaPtr clone(ds_arena::MonotonicArena& arena) const { return ArenaPtr{ clone_into(arena) }; }
 	};
 
+	void ArenaDeleter::operator()(Shape* shape) const noexcept { shape->~Shape(); }
+
 	template <typename T>
 	struct ShapeCRTP : public Shape {
 		virtual Shape* Clone() override { return new T(*static_cast<T*>(this)); }
+
+		std::unique_ptr<Shape> clone() const override { return std::make_unique<T>(*static_cast<const T*>(this)); }
+
+		Shape* clone_into(ds_arena::MonotonicArena& arena) const override {
+			return ::new (arena.allocate(sizeof(T), alignof(T))) T(*static_cast<const T*>(this));
+		}
 	};
 
 	struct Square : public ShapeCRTP<Square>
@@ -63,14 +96,87 @@ namespace temp_crtp {
 		int x = 1, y = 2;
 	};
 
+	class Scene {
+		ds_arena::MonotonicArena arena;
+		std::vector<Shape*> shapes;
+
+		void destroy() noexcept {
+			for (Shape* shape : shapes) shape->~Shape();
+			shapes.clear();
+		}
+
+	public:
+		explicit Scene(size_t block_size = 4 << 20) : arena{ block_size } {}
+		Scene(Scene&& other) noexcept : arena{ std::move(other.arena) }, shapes{ std::exchange(other.shapes, {}) } {}
+		Scene& operator=(Scene&& other) noexcept {
+			if (this != &other) {
+				destroy();
+				arena = std::move(other.arena);
+				shapes = std::exchange(other.shapes, {});
+			}
+			return *this;
+		}
+		~Scene() { destroy(); }
+
+		void reserve(size_t count) { shapes.reserve(count); }
+
+		Shape& add(const Shape& shape) {
+			Shape* copy = shape.clone_into(arena);
+			shapes.push_back(copy);
+			return *copy;
+		}
+
+		std::span<Shape* const> view() const { return shapes; }
+		size_t size() const { return shapes.size(); }
+		size_t block_count() const { return arena.block_count(); }
+	};
+
+	Scene clone_all(std::span<Shape* const> shapes) {
+		Scene scene;
+		scene.reserve(shapes.size());
+		for (const Shape* shape : shapes) scene.add(*shape);
+		return scene;
+	}
+
 	void main()
 	{
 		std::vector<Shape*> v;
 		v.push_back(new Square);
 		v.push_back(new Rectangel);
 		for (const auto& s : v) {
-			Shape* c = s->Clone(); //We are leaking memory here!!!
+			auto c = s->clone();	//No leak anymore, c owns the copy
+		}
+
+		ds_arena::MonotonicArena arena;
+		ArenaPtr square_copy = v[0]->clone(arena);
+		for (auto s : v) delete s;
+
+		//Snapshot a scene of millions of shapes: one new per copy against clone_all() into an arena.
+		const size_t count = 4000000;
+		std::vector<std::unique_ptr<Shape>> scene_owner;
+		std::vector<Shape*> scene;
+		for (size_t i = 0; i < count; ++i) {
+			scene_owner.push_back(i % 2 ? std::unique_ptr<Shape>{ new Square } : std::unique_ptr<Shape>{ new Rectangel });
+			scene.push_back(scene_owner.back().get());
+		}
 
+		auto start = std::chrono::steady_clock::now();
+		{
+			std::vector<std::unique_ptr<Shape>> snapshot;
+			snapshot.reserve(count);
+			for (const Shape* shape : scene) snapshot.push_back(shape->clone());
 		}
+		auto heap_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		size_t blocks = 0;
+		{
+			Scene snapshot = clone_all(scene);
+			blocks = snapshot.block_count();
+		}
+		auto arena_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "clone():     " << count << " allocations, " << heap_ms << " ms (copy + free)" << std::endl;
+		std::cout << "clone_all(): " << blocks << " blocks, " << arena_ms << " ms (copy + free)" << std::endl;
 	}
 }
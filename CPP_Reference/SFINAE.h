@@ -1,4 +1,17 @@
 #pragma once
+#include <bit>
+#include <array>
+#include <span>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include "templates_enum_reflection.h"
 
 //************************* Using enable_if to conditionally remove functions and class
 //https://stackoverflow.com/questions/14600201/why-should-i-avoid-stdenable-if-in-function-signatures?rq=1
@@ -50,3 +63,212 @@ struct Check3
 		return 3.14;
 	}
 };
+
+//*************************** Putting read<T>() to use: a typed binary reader
+//Check1..3 pick read<T>() by the type the caller asks for. BinaryReader does the same over a buffer of bytes (a memory mapped file, a
+//network packet, ...), one enable_if'd read<T>() per kind of type (the return type form of Check3):
+//	numbers			- integers and floating point, byte swapped if the data has the other byte order than the machine.
+//	bool			- one byte, anything but 0 is true.
+//	enums			- read as their underlying type.
+//	std::string_view- a uint32 length and the characters. The view points into the buffer, nothing is copied.
+//	records			- trivially copyable structs, copied as they are. Their fields can't be swapped, so only a reader in native order
+//					  accepts them (checked at compile time, like read_span).
+//read_span<T>(count) returns count records as a span that aliases the buffer (no copy, it must be suitably aligned).
+//Every read checks that the buffer is long enough. In a loop that is one compare and branch per field; unchecked(bytes) checks once for
+//a whole block and returns a reader over it whose reads have no checks. Lengths read from the data (string_view, read_span) are
+//checked anyway, they can't be known in advance.
+//Errors are exceptions: std::out_of_range past the end, std::runtime_error for misaligned spans.
+
+namespace sfinae_binary_reader {
+	template <size_t Size>
+	struct unsigned_of_size;
+	template <> struct unsigned_of_size<1> { using type = std::uint8_t; };
+	template <> struct unsigned_of_size<2> { using type = std::uint16_t; };
+	template <> struct unsigned_of_size<4> { using type = std::uint32_t; };
+	template <> struct unsigned_of_size<8> { using type = std::uint64_t; };
+
+	//Compiles to a single bswap instruction.
+	template <typename U>
+	constexpr U byteswap(U value) {
+		U result = 0;
+		for (size_t i = 0; i < sizeof(U); ++i) {
+			result = static_cast<U>((result << 8) | (value & 0xff));
+			value = static_cast<U>(value >> 8);
+		}
+		return result;
+	}
+
+	template <typename T>
+	inline constexpr bool is_number_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+	template <typename T>
+	inline constexpr bool is_record_v = std::is_class_v<T> && std::is_trivially_copyable_v<T> && !std::is_same_v<T, std::string_view>;
+
+	template <std::endian Order = std::endian::little, bool Checked = true>
+	class BinaryReader {
+		template <std::endian, bool>
+		friend class BinaryReader;
+
+		const char* first{ nullptr };
+		const char* cursor{ nullptr };
+		const char* last{ nullptr };
+
+		void require(size_t bytes) const {
+			if constexpr (Checked) {
+				if (bytes > remaining()) throw std::out_of_range("BinaryReader: read past the end of the buffer");
+			}
+		}
+
+		//Data from the file (lengths, counts) is checked even in an unchecked reader.
+		void require_always(size_t bytes) const {
+			if (bytes > remaining()) throw std::out_of_range("BinaryReader: read past the end of the buffer");
+		}
+
+	public:
+		BinaryReader(const void* data, size_t size)
+			: first{ static_cast<const char*>(data) }, cursor{ first }, last{ first + size } {}
+
+		size_t position() const { return static_cast<size_t>(cursor - first); }
+		size_t remaining() const { return static_cast<size_t>(last - cursor); }
+		const char* data() const { return cursor; }
+
+		void seek(size_t offset) {
+			if (offset > static_cast<size_t>(last - first)) throw std::out_of_range("BinaryReader: seek past the end of the buffer");
+			cursor = first + offset;
+		}
+
+		void skip(size_t bytes) {
+			require_always(bytes);
+			cursor += bytes;
+		}
+
+		//Checks once that bytes are left, returns a reader over them without checks and moves past them.
+		BinaryReader<Order, false> unchecked(size_t bytes) {
+			require_always(bytes);
+			BinaryReader<Order, false> block{ cursor, bytes };
+			cursor += bytes;
+			return block;
+		}
+
+		template <typename T>
+		std::enable_if_t<is_number_v<T>, T> read() {
+			using Bits = typename unsigned_of_size<sizeof(T)>::type;
+			require(sizeof(T));
+			Bits bits;
+			std::memcpy(&bits, cursor, sizeof(T));	//The buffer may not be aligned for T
+			cursor += sizeof(T);
+			if constexpr (Order != std::endian::native) bits = byteswap(bits);
+			return std::bit_cast<T>(bits);
+		}
+
+		template <typename T>
+		std::enable_if_t<std::is_same_v<T, bool>, T> read() {
+			return read<std::uint8_t>() != 0;
+		}
+
+		template <typename T>
+		std::enable_if_t<std::is_enum_v<T>, T> read() {
+			return static_cast<T>(read<std::underlying_type_t<T>>());
+		}
+
+		template <typename T>
+		std::enable_if_t<std::is_same_v<T, std::string_view>, T> read() {
+			const auto length = read<std::uint32_t>();
+			require_always(length);
+			std::string_view text{ cursor, length };
+			cursor += length;
+			return text;
+		}
+
+		template <typename T>
+		std::enable_if_t<is_record_v<T>, T> read() {
+			static_assert(Order == std::endian::native || sizeof(T) == 1, "The fields of a record can't be byte swapped, read them one by one");
+			require(sizeof(T));
+			T record;
+			std::memcpy(&record, cursor, sizeof(T));
+			cursor += sizeof(T);
+			return record;
+		}
+
+		//count records in place. The bytes are used as T objects, as with any memory mapped format (std::start_lifetime_as in C++23).
+		template <typename T>
+		std::span<const T> read_span(size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can alias raw bytes");
+			static_assert(Order == std::endian::native || sizeof(T) == 1, "The elements can't be byte swapped in place, read them one by one");
+			if (count > remaining() / sizeof(T)) throw std::out_of_range("BinaryReader: span past the end of the buffer");
+			if (reinterpret_cast<std::uintptr_t>(cursor) % alignof(T) != 0) throw std::runtime_error("BinaryReader: span is not aligned for its type");
+			std::span<const T> items{ reinterpret_cast<const T*>(cursor), count };
+			cursor += count * sizeof(T);
+			return items;
+		}
+	};
+
+	enum class Unit : std::uint8_t { celsius, kelvin };
+	constexpr std::array<std::string_view, 2> enum_names(Unit) { return { "celsius", "kelvin" }; }
+	std::ostream& operator<<(std::ostream& os, Unit unit) {
+		return templates_enum_reflection::write(os, unit);
+	}
+
+	struct Sample {
+		std::uint32_t sensor;
+		float value;
+	};
+
+	void main() {
+		//A log of measurements: uint32 count, then per entry a big endian uint32 sensor, a float, a unit and a name.
+		const std::uint32_t count = 1000000;
+		std::vector<char> buffer;
+		auto put = [&buffer](auto value, bool big_endian) {
+			using Bits = typename unsigned_of_size<sizeof(value)>::type;
+			auto bits = std::bit_cast<Bits>(value);
+			if (big_endian != (std::endian::native == std::endian::big)) bits = byteswap(bits);
+			const char* p = reinterpret_cast<const char*>(&bits);
+			buffer.insert(buffer.end(), p, p + sizeof(bits));
+		};
+		put(count, true);
+		for (std::uint32_t i = 0; i < count; ++i) {
+			put(i % 64, true);
+			put(20.0f + static_cast<float>(i % 100) / 10, true);
+			put(static_cast<std::uint8_t>(i % 2), true);
+			const std::string name = "sensor " + std::to_string(i % 64);
+			put(static_cast<std::uint32_t>(name.size()), true);
+			buffer.insert(buffer.end(), name.begin(), name.end());
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		BinaryReader<std::endian::big> reader{ buffer.data(), buffer.size() };
+		const auto entries = reader.read<std::uint32_t>();
+		double kelvin = 0;
+		size_t name_chars = 0;
+		size_t per_unit[2]{};
+		for (std::uint32_t i = 0; i < entries; ++i) {
+			auto fixed = reader.unchecked(9);	//One bounds check for the 3 fixed size fields
+			const auto sensor = fixed.read<std::uint32_t>();
+			const auto value = fixed.read<float>();
+			const auto unit = fixed.read<Unit>();
+			kelvin += unit == Unit::kelvin ? value : value + 273.15;
+			++per_unit[static_cast<size_t>(unit)];
+			name_chars += reader.read<std::string_view>().size() + sensor;
+		}
+		auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << entries << " big endian entries read in " << ms << " ms (" << buffer.size() / ms / 1e6 << " GB/s), average "
+			<< kelvin / entries << " K, " << name_chars << std::endl;
+		std::cout << per_unit[0] << " in " << Unit::celsius << ", " << per_unit[1] << " in " << Unit::kelvin << std::endl;
+
+		//Records in native order are used in place.
+		std::vector<Sample> samples(count);
+		for (std::uint32_t i = 0; i < count; ++i) samples[i] = { i, static_cast<float>(i) };
+		BinaryReader<std::endian::native> native{ samples.data(), samples.size() * sizeof(Sample) };
+		const auto first = native.read<Sample>();
+		const auto rest = native.read_span<Sample>(count - 1);
+		std::cout << "First sample " << first.sensor << ", then a span of " << rest.size() << " aliasing the buffer: "
+			<< (static_cast<const void*>(rest.data()) == static_cast<const void*>(samples.data() + 1)) << std::endl;
+
+		try {
+			native.read<std::uint32_t>();
+		}
+		catch (const std::out_of_range& e) {
+			std::cout << e.what() << std::endl;
+		}
+	}
+}
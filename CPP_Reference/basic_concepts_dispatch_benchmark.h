@@ -0,0 +1,284 @@
+#pragma once
+#include <tuple>
+#include <memory>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <variant>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+//The project shows several ways to call "the right function for this object":
+//	virtual functions (dp_decorator_dynamic), CRTP (temp_crtp_1::Base<T>, the db_decorator_static mixins), std::function
+//	(dp_decorator_function.h), std::variant + std::visit (ds_poly_collection), and plain function pointers.
+//This benchmark runs the same workload (sum the area of a list of shapes) with each of them, for 1 to 16 different shape types and two
+//call site patterns:
+//	sorted	- the shapes come in long runs of the same type, the indirect branch predictor guesses right almost always.
+//	random	- the types are in random order, every indirect call can be mispredicted.
+//CRTP needs the type at compile time, so it can only run over one type at a time (segments, like ds_poly_collection).
+//Reported per call: nanoseconds, time stamp counter cycles (reference cycles, not core clock cycles), and on Linux branch and
+//instruction cache misses from the hardware performance counters (n/a where the kernel doesn't allow reading them).
+
+namespace basic_concepts_dispatch_benchmark {
+	inline std::uint64_t read_cycles() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	//One hardware event counted for the calling thread, user space only.
+	class PerfCounter {
+		int fd{ -1 };
+
+	public:
+		PerfCounter(std::uint32_t type, std::uint64_t config) {
+#if defined(__linux__)
+			perf_event_attr attr{};
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+		}
+		PerfCounter(const PerfCounter&) = delete;
+		PerfCounter& operator=(const PerfCounter&) = delete;
+		~PerfCounter() {
+#if defined(__linux__)
+			if (fd >= 0) close(fd);
+#endif
+		}
+
+		bool available() const { return fd >= 0; }
+
+		void start() {
+#if defined(__linux__)
+			if (fd < 0) return;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+		}
+
+		std::uint64_t stop() {
+			std::uint64_t value = 0;
+#if defined(__linux__)
+			if (fd < 0) return 0;
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#endif
+			return value;
+		}
+
+		static PerfCounter branch_misses() {
+#if defined(__linux__)
+			return PerfCounter{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES };
+#else
+			return PerfCounter{ 0, 0 };
+#endif
+		}
+
+		static PerfCounter icache_misses() {
+#if defined(__linux__)
+			return PerfCounter{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+#else
+			return PerfCounter{ 0, 0 };
+#endif
+		}
+	};
+
+	//Every shape type gets its own code, so more types means more distinct call targets and more code in the instruction cache.
+	template <int K>
+	double compute_area(double x) {
+		return x * x * (K + 1) + (K % 3) * x + K * 0.5;
+	}
+
+	struct VirtualShape {
+		virtual double area() const = 0;
+		virtual ~VirtualShape() = default;
+	};
+
+	template <int K>
+	struct VirtualKind final : VirtualShape {
+		double x;
+		explicit VirtualKind(double x_) : x{ x_ } {}
+		double area() const override { return compute_area<K>(x); }
+	};
+
+	//The alternatives of the variant: no base class and no vptr, std::visit dispatches on the index stored next to them.
+	template <int K>
+	struct PlainKind {
+		double x;
+		double area() const { return compute_area<K>(x); }
+	};
+
+	template <typename Derived>
+	struct CrtpShape {
+		double area() const { return static_cast<const Derived*>(this)->area_impl(); }
+	};
+
+	template <int K>
+	struct CrtpKind : CrtpShape<CrtpKind<K>> {
+		double x;
+		explicit CrtpKind(double x_) : x{ x_ } {}
+		double area_impl() const { return compute_area<K>(x); }
+	};
+
+	//The "C way": the object carries a pointer to its function.
+	struct PointerShape {
+		double (*area)(double);
+		double x;
+	};
+
+	struct Result {
+		double ns{ 0 };
+		double cycles{ 0 };
+		double branch_misses{ -1 };
+		double icache_misses{ -1 };
+		double checksum{ 0 };	//The sum of the areas, keeps the optimizer from dropping the work
+	};
+
+	template <typename Body>
+	Result measure(size_t calls, int rounds, Body&& body) {
+		PerfCounter branches = PerfCounter::branch_misses();
+		PerfCounter icache = PerfCounter::icache_misses();
+		const double warm_up = body();	//Caches and predictors
+
+		branches.start();
+		icache.start();
+		const auto start = std::chrono::steady_clock::now();
+		const auto start_cycles = read_cycles();
+		double sum = 0;
+		for (int r = 0; r < rounds; ++r) sum += body();
+		const auto cycles = read_cycles() - start_cycles;
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		const auto branch_count = branches.stop();
+		const auto icache_count = icache.stop();
+
+		const double total = static_cast<double>(calls) * rounds;
+		Result result;
+		result.ns = std::chrono::duration<double, std::nano>(elapsed).count() / total;
+		result.cycles = static_cast<double>(cycles) / total;
+		if (branches.available()) result.branch_misses = static_cast<double>(branch_count) / total;
+		if (icache.available()) result.icache_misses = static_cast<double>(icache_count) / total;
+		result.checksum = warm_up + sum;
+		return result;
+	}
+
+	void print(const char* strategy, size_t types, const char* order, const Result& r) {
+		std::cout << std::left << std::setw(16) << strategy << std::right << std::setw(6) << types << std::setw(8) << order
+			<< std::fixed << std::setprecision(2) << std::setw(10) << r.ns << std::setw(10) << r.cycles;
+		if (r.branch_misses >= 0) std::cout << std::setw(14) << r.branch_misses;
+		else std::cout << std::setw(14) << "n/a";
+		if (r.icache_misses >= 0) std::cout << std::setw(14) << r.icache_misses;
+		else std::cout << std::setw(14) << "n/a";
+		std::cout << std::defaultfloat << std::setprecision(6) << '\n';
+	}
+
+	//Every measurement makes about this many calls, however many shapes there are.
+	inline constexpr size_t calls_per_measurement = size_t{ 1 } << 22;
+
+	template <size_t N, size_t... Ks>
+	void run(size_t count, bool random_order, std::index_sequence<Ks...>) {
+		const int rounds = static_cast<int>(std::max<size_t>(1, calls_per_measurement / count));
+		const char* order = random_order ? "random" : "sorted";
+
+		//The same sequence of (type, x) for every strategy.
+		std::mt19937 rng{ 1234 };
+		std::uniform_real_distribution<double> value{ 1.0, 2.0 };
+		std::vector<std::pair<size_t, double>> items(count);
+		for (size_t i = 0; i < count; ++i) items[i] = { random_order ? rng() % N : i * N / count, value(rng) };
+
+		{
+			using Factory = std::unique_ptr<VirtualShape>(*)(double);
+			static constexpr Factory factories[] = { [](double x) -> std::unique_ptr<VirtualShape> { return std::make_unique<VirtualKind<Ks>>(x); }... };
+			std::vector<std::unique_ptr<VirtualShape>> shapes;
+			for (const auto& [type, x] : items) shapes.push_back(factories[type](x));
+			print("virtual", N, order, measure(count, rounds, [&] {
+				double sum = 0;
+				for (const auto& shape : shapes) sum += shape->area();
+				return sum;
+			}));
+		}
+		{
+			using Variant = std::variant<PlainKind<Ks>...>;
+			using Factory = Variant(*)(double);
+			static constexpr Factory factories[] = { [](double x) -> Variant { return PlainKind<Ks>{ x }; }... };
+			std::vector<Variant> shapes;
+			for (const auto& [type, x] : items) shapes.push_back(factories[type](x));
+			print("variant/visit", N, order, measure(count, rounds, [&] {
+				double sum = 0;
+				for (const auto& shape : shapes) sum += std::visit([](const auto& s) { return s.area(); }, shape);
+				return sum;
+			}));
+		}
+		{
+			static constexpr double (*functions[])(double) = { &compute_area<Ks>... };
+			std::vector<PointerShape> shapes;
+			for (const auto& [type, x] : items) shapes.push_back({ functions[type], x });
+			print("function ptr", N, order, measure(count, rounds, [&] {
+				double sum = 0;
+				for (const auto& shape : shapes) sum += shape.area(shape.x);
+				return sum;
+			}));
+
+			std::vector<std::function<double()>> calls;
+			for (const auto& [type, x] : items) calls.emplace_back([f = functions[type], x = x] { return f(x); });
+			print("std::function", N, order, measure(count, rounds, [&] {
+				double sum = 0;
+				for (const auto& call : calls) sum += call();
+				return sum;
+			}));
+		}
+		if (!random_order) {
+			std::tuple<std::vector<CrtpKind<Ks>>...> segments;
+			for (const auto& [type, x] : items) {
+				((type == Ks ? (std::get<Ks>(segments).emplace_back(x), 0) : 0), ...);
+			}
+			print("CRTP segments", N, "-", measure(count, rounds, [&] {
+				double sum = 0;
+				std::apply([&sum](const auto&... segment) { ((std::for_each(segment.begin(), segment.end(), [&sum](const auto& s) { sum += s.area(); })), ...); }, segments);
+				return sum;
+			}));
+		}
+	}
+
+	template <size_t N>
+	void run(size_t count) {
+		run<N>(count, false, std::make_index_sequence<N>{});
+		run<N>(count, true, std::make_index_sequence<N>{});
+	}
+
+	void main() {
+		//8192 shapes: the largest layout (virtual, 8192 pointers plus 8192 heap objects of 32 bytes) takes about 320 KB, the others less.
+		//That stays in the L2 cache of current cores, so the dispatch dominates rather than memory. The list is run many times instead.
+		const size_t count = 1 << 13;
+		std::cout << std::left << std::setw(16) << "strategy" << std::right << std::setw(6) << "types" << std::setw(8) << "order"
+			<< std::setw(10) << "ns/call" << std::setw(10) << "cyc/call" << std::setw(14) << "br-miss/call" << std::setw(14) << "i$-miss/call" << '\n';
+		run<1>(count);
+		run<2>(count);
+		run<4>(count);
+		run<8>(count);
+		run<16>(count);
+		std::cout << std::flush;
+	}
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+//A work stealing thread pool.
+//Every worker has its own queue. Tasks submitted from inside a task go to the queue of the worker that runs it, and the worker takes
+//its own tasks from the back (the newest, whose data is still in the cache). A worker with an empty queue first looks at the queue for
+//submissions from outside the pool and then steals from the front of another worker's queue (the oldest task, usually the biggest piece
+//of work). Hence there is no single queue all threads fight over, and recursive divide and conquer spreads over the pool by itself.
+//A thread that waits for a result of the pool can help instead of blocking (ThreadPool::wait), so tasks may wait for their subtasks.
+
+namespace concurrency_thread_pool {
+	//std::function needs a copyable callable, a std::packaged_task isn't. This one only needs to be movable.
+	class Task {
+		struct Base {
+			virtual ~Base() = default;
+			virtual void run() = 0;
+		};
+
+		template <typename F>
+		struct Impl : Base {
+			F func;
+			template <typename G>
+			explicit Impl(G&& g) : func{ std::forward<G>(g) } {}
+			void run() override { func(); }
+		};
+
+		std::unique_ptr<Base> impl;
+
+	public:
+		Task() = default;
+
+		template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+		Task(F&& f) : impl{ std::make_unique<Impl<std::decay_t<F>>>(std::forward<F>(f)) } {}
+
+		void operator() () { impl->run(); }
+	};
+
+	class ThreadPool {
+		struct alignas(64) WorkQueue {
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<WorkQueue>> queues;	//One per worker
+		WorkQueue injected;	//Submissions from threads outside the pool
+		std::vector<std::thread> workers;
+
+		std::mutex sleep_lock;
+		std::condition_variable wake;
+		std::atomic<size_t> pending{ 0 };	//Tasks sitting in any of the queues
+		bool stopping{ false };
+		std::atomic<size_t> steals{ 0 };
+
+		static inline thread_local ThreadPool* current_pool = nullptr;
+		static inline thread_local size_t current_index = 0;
+
+		static bool pop_back(WorkQueue& queue, Task& task) {
+			std::lock_guard<std::mutex> guard{ queue.lock };
+			if (queue.tasks.empty()) return false;
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			return true;
+		}
+
+		static bool pop_front(WorkQueue& queue, Task& task) {
+			std::lock_guard<std::mutex> guard{ queue.lock };
+			if (queue.tasks.empty()) return false;
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			return true;
+		}
+
+		bool try_get(Task& task) {
+			const bool is_worker = current_pool == this;
+			if (is_worker && pop_back(*queues[current_index], task)) return true;
+			if (pop_front(injected, task)) return true;
+			const size_t first = is_worker ? current_index + 1 : 0;
+			for (size_t i = 0; i < queues.size(); ++i) {
+				auto& victim = *queues[(first + i) % queues.size()];
+				if (pop_front(victim, task)) {
+					steals.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void push(Task task) {
+			auto& queue = current_pool == this ? *queues[current_index] : injected;
+			{
+				std::lock_guard<std::mutex> guard{ queue.lock };
+				queue.tasks.push_back(std::move(task));
+			}
+			{
+				std::lock_guard<std::mutex> guard{ sleep_lock };	//Under the lock, so a worker about to sleep can't miss it
+				pending.fetch_add(1, std::memory_order_relaxed);
+			}
+			wake.notify_one();
+		}
+
+		void worker_loop(size_t index) {
+			current_pool = this;
+			current_index = index;
+			Task task;
+			while (true) {
+				if (try_get(task)) {
+					pending.fetch_sub(1, std::memory_order_relaxed);
+					task();
+					continue;
+				}
+				std::unique_lock<std::mutex> guard{ sleep_lock };
+				wake.wait(guard, [this] { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+				if (stopping && pending.load(std::memory_order_relaxed) == 0) return;
+			}
+		}
+
+	public:
+		explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+			for (size_t i = 0; i < threads; ++i) queues.push_back(std::make_unique<WorkQueue>());
+			for (size_t i = 0; i < threads; ++i) workers.emplace_back([this, i] { worker_loop(i); });
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		//Runs what is still queued, then joins.
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> guard{ sleep_lock };
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& worker : workers) worker.join();
+		}
+
+		//The pool decorators and algorithms use unless they are given another one.
+		static ThreadPool& shared() {
+			static ThreadPool pool;
+			return pool;
+		}
+
+		template <typename F, typename... Args>
+		auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+			using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+			std::packaged_task<R()> task{ [f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable {
+				return std::invoke(std::move(f), std::move(args)...);
+			} };
+			auto result = task.get_future();
+			push(Task{ std::move(task) });
+			return result;
+		}
+
+		//Runs one queued task on the calling thread. Returns false if there was none.
+		bool run_pending_task() {
+			Task task;
+			if (!try_get(task)) return false;
+			pending.fetch_sub(1, std::memory_order_relaxed);
+			task();
+			return true;
+		}
+
+		//Like future.get(), but the waiting thread runs queued tasks meanwhile. A task waiting for its subtasks can't deadlock the pool.
+		template <typename T>
+		T wait(std::future<T>& result) {
+			while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				if (!run_pending_task()) std::this_thread::yield();
+			}
+			return result.get();
+		}
+
+		size_t size() const { return workers.size(); }
+		size_t steal_count() const { return steals.load(std::memory_order_relaxed); }
+	};
+
+	//Divide and conquer: every call splits its range and submits the left half, the pool spreads the halves by stealing.
+	long long parallel_sum(ThreadPool& pool, const int* first, const int* last) {
+		if (last - first <= 100000) return std::accumulate(first, last, 0ll);
+		const int* middle = first + (last - first) / 2;
+		auto left = pool.submit(parallel_sum, std::ref(pool), first, middle);
+		long long right = parallel_sum(pool, middle, last);
+		return pool.wait(left) + right;
+	}
+
+	void main() {
+		ThreadPool& pool = ThreadPool::shared();
+		std::vector<int> values(20000000);
+		std::iota(values.begin(), values.end(), 0);
+
+		auto start = std::chrono::steady_clock::now();
+		long long serial = std::accumulate(values.begin(), values.end(), 0ll);
+		auto serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		auto total = pool.submit(parallel_sum, std::ref(pool), values.data(), values.data() + values.size());
+		long long parallel = pool.wait(total);
+		auto parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "Serial:   " << serial << " in " << serial_ms << " ms" << std::endl;
+		std::cout << "Parallel: " << parallel << " in " << parallel_ms << " ms on " << pool.size() << " threads, "
+			<< pool.steal_count() << " tasks stolen" << std::endl;
+	}
+}
@@ -1,21 +1,27 @@
 #pragma once
+#include <array>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
+#include <utility>
 #include <iostream>
 #include <type_traits>
+#include "ds_arena.h"
+#include "templates_enum_reflection.h"
 
 namespace dp_SOLID_Filter {
 	enum class Color { red, green, blue };
+	constexpr std::array<std::string_view, 3> enum_names(Color) { return { "Red", "Green", "Blue" }; }
 	std::ostream& operator<<(std::ostream& os, Color c) {
-		switch (c) {
-			case Color::red:	std::cout << "Red"; break;
-			case Color::green:	std::cout << "Green"; break;
-			case Color::blue:	std::cout << "Blue"; break;
-		}
-		return os;
+		return templates_enum_reflection::write(os, c);
 	}
 
 	enum class Size { small, medium, large };
+	constexpr std::array<std::string_view, 3> enum_names(Size) { return { "Small", "Medium", "Large" }; }
+	std::ostream& operator<<(std::ostream& os, Size s) {
+		return templates_enum_reflection::write(os, s);
+	}
 
 	struct Product {
 		std::string name;
@@ -37,16 +43,18 @@ namespace dp_SOLID_Filter {
 	};
 
 	std::ostream& operator<<(std::ostream& os, const Product& prod) {
-		os << "Name = " << prod.name << ", Color = " << prod.color << ", size = " << static_cast<int>(prod.size) << std::endl;
+		os << "Name = " << prod.name << ", Color = " << prod.color << ", size = " << prod.size << '\n';
 		return os;
 	}
 
 	void main() {
+		//The products live in an arena owned by main(), they are released together when it returns.
+		ds_arena::ObjectArena<Product> arena;
 		std::vector<Product*> products;
-		products.push_back(new Product{ "Product 1", Color::green, Size::small });
-		products.push_back(new Product{ "Product 2", Color::red, Size::medium});
-		products.push_back(new Product{ "Product 3", Color::green, Size::large });
-		products.push_back(new Product{ "Product 4", Color::blue, Size::small });
+		products.push_back(arena.emplace("Product 1", Color::green, Size::small));
+		products.push_back(arena.emplace("Product 2", Color::red, Size::medium));
+		products.push_back(arena.emplace("Product 3", Color::green, Size::large));
+		products.push_back(arena.emplace("Product 4", Color::blue, Size::small));
 		
 		auto filtered_products = ProductFilter{}.by_color(products, Color::green);
 
@@ -59,23 +67,15 @@ namespace dp_SOLID_Filter {
 namespace dp_SOLID_Specification {
 
 	enum class Color { red, green, blue };
+	constexpr std::array<std::string_view, 3> enum_names(Color) { return { "Red", "Green", "Blue" }; }
 	std::ostream& operator<<(std::ostream& os, Color c) {
-		switch (c) {
-		case Color::red:	std::cout << "Red"; break;
-		case Color::green:	std::cout << "Green"; break;
-		case Color::blue:	std::cout << "Blue"; break;
-		}
-		return os;
+		return templates_enum_reflection::write(os, c);
 	}
 
 	enum class Size { small, medium, large };
+	constexpr std::array<std::string_view, 3> enum_names(Size) { return { "Small", "Medium", "Large" }; }
 	std::ostream& operator<<(std::ostream& os, Size s) {
-		switch (s) {
-		case Size::small:	std::cout << "Small"; break;
-		case Size::medium:	std::cout << "Medium"; break;
-		case Size::large:	std::cout << "Large"; break;
-		}
-		return os;
+		return templates_enum_reflection::write(os, s);
 	}
 
 	struct Product {
@@ -85,20 +85,20 @@ namespace dp_SOLID_Specification {
 	};
 
 	std::ostream& operator<<(std::ostream& os, const Product& prod) {
-		os << "Name = " << prod.name << ", Color = " << prod.color << ", size = " << prod.size << std::endl;
+		os << "Name = " << prod.name << ", Color = " << prod.color << ", size = " << prod.size << '\n';
 		return os;
 	}
 	template <typename>
 	class AndSpecification;
+	template <typename>
+	class OrSpecification;
 
 	template <typename T>
 	class Specification {
 	public:
+		using item_type = T;
+		virtual ~Specification() = default;
 		virtual bool is_satisfied(T* item) = 0;
-
-		AndSpecification<T> operator&&(Specification<T>&& other) {
-			return AndSpecification<T>{*this, other};
-		}
 	};
 
 	template <typename T>
@@ -106,6 +106,7 @@ namespace dp_SOLID_Specification {
 		Size size;
 	public:
 		SizeSpec(Size s) :size(s) {}
+		Size get_size() const { return size; }
 		bool is_satisfied(T* item) override {
 			return item->size == size;
 		}
@@ -116,23 +117,105 @@ namespace dp_SOLID_Specification {
 		Color color;
 	public:
 		ColorSpec(Color c) :color(c) {}
+		Color get_color() const { return color; }
 		bool is_satisfied(T* item) override {
 			return item->color == color;
 		}
 	};
 
+	enum class NameMatch { Exact, Prefix, Contains };
+	constexpr std::array<std::string_view, 3> enum_names(NameMatch) { return { "equals", "starts with", "contains" }; }
+	std::ostream& operator<<(std::ostream& os, NameMatch m) {
+		return templates_enum_reflection::write(os, m);
+	}
+
+	template <typename T>
+	class NameSpec : public Specification<T> {
+		std::string name;
+		NameMatch match;
+	public:
+		NameSpec(std::string n, NameMatch m = NameMatch::Exact) :name(std::move(n)), match(m) {}
+		const std::string& get_name() const { return name; }
+		NameMatch get_match() const { return match; }
+		bool is_satisfied(T* item) override {
+			std::string_view item_name{ item->name };
+			switch (match) {
+			case NameMatch::Prefix:		return item_name.substr(0, name.size()) == name;
+			case NameMatch::Contains:	return item_name.find(name) != std::string_view::npos;
+			default:					return item_name == name;
+			}
+		}
+	};
+
+	template <typename T>
+	class NotSpecification : public Specification<T> {
+		Specification<T>& spec;
+
+	public:
+		NotSpecification(Specification<T>& s) :spec{ s } {}
+		bool is_satisfied(T* item) override {
+			return !spec.is_satisfied(item);
+		}
+
+		Specification<T>& operand() const { return spec; }
+	};
+
+	//Composed from references the operands must outlive it, composed from shared_ptrs (what && and || do) it owns them.
 	template <typename T>
 	class AndSpecification : public Specification<T> {
+		std::shared_ptr<Specification<T>> owned_left, owned_right;
 		Specification<T>& left;
 		Specification<T>& right;
 
 	public:
 		AndSpecification(Specification<T>& l, Specification<T>& r) :left{ l }, right{ r }{}
+		AndSpecification(std::shared_ptr<Specification<T>> l, std::shared_ptr<Specification<T>> r)
+			:owned_left{ std::move(l) }, owned_right{ std::move(r) }, left{ *owned_left }, right{ *owned_right } {}
 		bool is_satisfied(T* item) override {
 			return left.is_satisfied(item) && right.is_satisfied(item);
 		}
+
+		//The operands are exposed so that tools like the query planner can walk a composed specification.
+		Specification<T>& lhs() const { return left; }
+		Specification<T>& rhs() const { return right; }
+	};
+
+	template <typename T>
+	class OrSpecification : public Specification<T> {
+		std::shared_ptr<Specification<T>> owned_left, owned_right;
+		Specification<T>& left;
+		Specification<T>& right;
+
+	public:
+		OrSpecification(Specification<T>& l, Specification<T>& r) :left{ l }, right{ r }{}
+		OrSpecification(std::shared_ptr<Specification<T>> l, std::shared_ptr<Specification<T>> r)
+			:owned_left{ std::move(l) }, owned_right{ std::move(r) }, left{ *owned_left }, right{ *owned_right } {}
+		bool is_satisfied(T* item) override {
+			return left.is_satisfied(item) || right.is_satisfied(item);
+		}
+
+		Specification<T>& lhs() const { return left; }
+		Specification<T>& rhs() const { return right; }
 	};
 
+	template <typename L, typename R>
+	using enable_if_specs = std::enable_if_t<std::is_base_of_v<Specification<typename std::decay_t<L>::item_type>, std::decay_t<L>>
+		&& std::is_base_of_v<Specification<typename std::decay_t<L>::item_type>, std::decay_t<R>>>;
+
+	//The operands are moved (temporaries) or copied into the result, which owns them. Unlike an AndSpecification built from references,
+	//auto spec = ColorSpec<Product>{ Color::red } && SizeSpec<Product>{ Size::large }; is safe to keep.
+	template <typename L, typename R, typename = enable_if_specs<L, R>>
+	auto operator&&(L&& l, R&& r) {
+		return AndSpecification<typename std::decay_t<L>::item_type>{
+			std::make_shared<std::decay_t<L>>(std::forward<L>(l)), std::make_shared<std::decay_t<R>>(std::forward<R>(r)) };
+	}
+
+	template <typename L, typename R, typename = enable_if_specs<L, R>>
+	auto operator||(L&& l, R&& r) {
+		return OrSpecification<typename std::decay_t<L>::item_type>{
+			std::make_shared<std::decay_t<L>>(std::forward<L>(l)), std::make_shared<std::decay_t<R>>(std::forward<R>(r)) };
+	}
+
 	template <typename T>
 	class Filter {
 	public:
@@ -153,11 +236,13 @@ namespace dp_SOLID_Specification {
 	};
 
 	void main() {
+		//The products live in an arena owned by main(), they are released together when it returns.
+		ds_arena::ObjectArena<Product> arena;
 		std::vector<Product*> products;
-		products.push_back(new Product{ "Product 1", Color::green, Size::small });
-		products.push_back(new Product{ "Product 2", Color::red, Size::medium });
-		products.push_back(new Product{ "Product 3", Color::red, Size::large });
-		products.push_back(new Product{ "Product 4", Color::blue, Size::small });
+		products.push_back(arena.emplace("Product 1", Color::green, Size::small));
+		products.push_back(arena.emplace("Product 2", Color::red, Size::medium));
+		products.push_back(arena.emplace("Product 3", Color::red, Size::large));
+		products.push_back(arena.emplace("Product 4", Color::blue, Size::small));
 
 		ColorSpec<Product> red_prod{ Color::red };
 		SizeSpec<Product> small_prod{ Size::large };
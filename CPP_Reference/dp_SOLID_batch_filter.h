@@ -0,0 +1,178 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include "dp_SOLID_OCP.h"
+
+//Running N specifications with N calls to BetterFilter::filter() walks the product list N times.
+//Once the list does not fit into the cache anymore, every pass pays the memory traffic again.
+//The batch filter makes a single pass instead: the products are processed in blocks of 64, every predicate of every query is evaluated
+//on the block while it is hot in the cache, and the result of each predicate is kept as a 64 bit mask (bit i == product i passed).
+//Predicates are "hash-consed": the same ColorSpec value (or the same And/Or sub-tree) used by many queries is evaluated once per block.
+//Color and size are first copied into small byte columns, so the leaf comparisons are simple loops the compiler can vectorize.
+
+namespace dp_SOLID_batch_filter {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::OrSpecification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::SizeSpec;
+	using dp_SOLID_Specification::BetterFilter;
+
+	class BatchFilter {
+		static constexpr size_t block_size = 64;
+
+		enum class Op : std::uint8_t { ColorEq, SizeEq, Opaque, And, Or };
+
+		//Nodes are stored in topological order (children before parents), so a block is evaluated with one forward loop.
+		struct Node {
+			Op op;
+			std::uint8_t value{ 0 };					//ColorEq/SizeEq
+			Specification<Product>* spec{ nullptr };	//Opaque: anything we can't look into is called through the virtual interface
+			size_t lhs{ 0 }, rhs{ 0 };					//And/Or
+		};
+
+		std::vector<Node> nodes;
+		std::unordered_map<std::string, size_t> node_ids;	//Structural key -> node, this is where the sharing happens
+
+		size_t intern(const std::string& key, const Node& node) {
+			auto found = node_ids.find(key);
+			if (found != node_ids.end()) return found->second;
+			nodes.push_back(node);
+			node_ids.emplace(key, nodes.size() - 1);
+			return nodes.size() - 1;
+		}
+
+		size_t compile(Specification<Product>& spec) {
+			if (auto color_spec = dynamic_cast<ColorSpec<Product>*>(&spec)) {
+				auto value = static_cast<std::uint8_t>(color_spec->get_color());
+				return intern("c" + std::to_string(value), Node{ Op::ColorEq, value });
+			}
+			if (auto size_spec = dynamic_cast<SizeSpec<Product>*>(&spec)) {
+				auto value = static_cast<std::uint8_t>(size_spec->get_size());
+				return intern("s" + std::to_string(value), Node{ Op::SizeEq, value });
+			}
+			if (auto and_spec = dynamic_cast<AndSpecification<Product>*>(&spec)) {
+				size_t l = compile(and_spec->lhs()), r = compile(and_spec->rhs());
+				return intern("&(" + std::to_string(l) + "," + std::to_string(r) + ")", Node{ Op::And, 0, nullptr, l, r });
+			}
+			if (auto or_spec = dynamic_cast<OrSpecification<Product>*>(&spec)) {
+				size_t l = compile(or_spec->lhs()), r = compile(or_spec->rhs());
+				return intern("|(" + std::to_string(l) + "," + std::to_string(r) + ")", Node{ Op::Or, 0, nullptr, l, r });
+			}
+			return intern("o" + std::to_string(reinterpret_cast<std::uintptr_t>(&spec)), Node{ Op::Opaque, 0, &spec });
+		}
+
+		template <typename Column>
+		static std::uint64_t equal_mask(const Column& column, size_t count, std::uint8_t value) {
+			std::uint64_t mask = 0;
+			for (size_t i = 0; i < count; ++i) {
+				mask |= static_cast<std::uint64_t>(column[i] == value) << i;
+			}
+			return mask;
+		}
+
+	public:
+		//Returns one result vector per specification, in the same order as specs.
+		std::vector<std::vector<Product*>> filter(const std::vector<Product*>& items, const std::vector<Specification<Product>*>& specs) {
+			nodes.clear();
+			node_ids.clear();
+			std::vector<size_t> roots;
+			for (auto spec : specs) roots.push_back(compile(*spec));
+
+			std::vector<std::vector<Product*>> results(specs.size());
+			std::vector<std::uint64_t> masks(nodes.size());
+			std::uint8_t colors[block_size];
+			std::uint8_t sizes[block_size];
+
+			for (size_t begin = 0; begin < items.size(); begin += block_size) {
+				const size_t count = std::min(block_size, items.size() - begin);
+				Product* const* block = items.data() + begin;
+
+				for (size_t i = 0; i < count; ++i) {
+					colors[i] = static_cast<std::uint8_t>(block[i]->color);
+					sizes[i] = static_cast<std::uint8_t>(block[i]->size);
+				}
+
+				for (size_t n = 0; n < nodes.size(); ++n) {
+					const Node& node = nodes[n];
+					switch (node.op) {
+					case Op::ColorEq: masks[n] = equal_mask(colors, count, node.value); break;
+					case Op::SizeEq: masks[n] = equal_mask(sizes, count, node.value); break;
+					case Op::And: masks[n] = masks[node.lhs] & masks[node.rhs]; break;
+					case Op::Or: masks[n] = masks[node.lhs] | masks[node.rhs]; break;
+					case Op::Opaque: {
+						std::uint64_t mask = 0;
+						for (size_t i = 0; i < count; ++i) {
+							mask |= static_cast<std::uint64_t>(node.spec->is_satisfied(block[i])) << i;
+						}
+						masks[n] = mask;
+						break;
+					}
+					}
+				}
+
+				for (size_t q = 0; q < roots.size(); ++q) {
+					//Visit the set bits only.
+					for (std::uint64_t mask = masks[roots[q]]; mask; mask &= mask - 1) {
+						results[q].push_back(block[std::countr_zero(mask)]);
+					}
+				}
+			}
+			return results;
+		}
+
+		//Number of distinct predicates of the last batch, after sharing.
+		size_t node_count() const { return nodes.size(); }
+	};
+
+	void main() {
+		std::vector<Product> storage;
+		for (int i = 0; i < 1000000; ++i) {
+			storage.push_back(Product{ "Product " + std::to_string(i), static_cast<Color>(i % 3), static_cast<Size>((i / 7) % 3) });
+		}
+		std::vector<Product*> products;
+		for (auto& p : storage) products.push_back(&p);
+
+		//Every combination of one color and one size, each query built from its own specification objects.
+		std::vector<std::unique_ptr<Specification<Product>>> parts;
+		std::vector<Specification<Product>*> specs;
+		for (int repeat = 0; repeat < 20; ++repeat) {
+			for (int c = 0; c < 3; ++c) {
+				for (int s = 0; s < 3; ++s) {
+					parts.push_back(std::make_unique<ColorSpec<Product>>(static_cast<Color>(c)));
+					auto& color = *parts.back();
+					parts.push_back(std::make_unique<SizeSpec<Product>>(static_cast<Size>(s)));
+					auto& size = *parts.back();
+					parts.push_back(std::make_unique<AndSpecification<Product>>(color, size));
+					specs.push_back(parts.back().get());
+				}
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		size_t one_by_one = 0;
+		for (auto spec : specs) one_by_one += BetterFilter{}.filter(products, *spec).size();
+		auto one_by_one_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		BatchFilter batch;
+		start = std::chrono::steady_clock::now();
+		auto results = batch.filter(products, specs);
+		auto batch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		size_t batched = 0;
+		for (const auto& r : results) batched += r.size();
+
+		std::cout << specs.size() << " queries, " << batch.node_count() << " distinct predicates after sharing" << std::endl;
+		std::cout << "BetterFilter one by one: " << one_by_one << " rows in " << one_by_one_ms << " ms" << std::endl;
+		std::cout << "BatchFilter single pass: " << batched << " rows in " << batch_ms << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,366 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <bit>
+#include <span>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include "dp_SOLID_OCP.h"
+#include "dp_SOLID_product_catalog.h"
+#include "templates_enum_reflection.h"
+#include "SFINAE.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//Loading ProductCatalog from large exports. Two formats:
+//	CSV		"name,color,size" per line, e.g. "Product 1,green,small". The file is memory mapped and cut into one chunk per thread,
+//			every chunk boundary is moved to the next '\n' so that no line is split. Each thread parses its chunk with a hand-written
+//			parser (memchr for the separators, perfect hashes for the enums) into rows that point into the mapping, nothing is copied.
+//			Only interning the names into the catalog is done by a single thread at the end.
+//	Binary	A header, a fixed size record per product and one blob with all names. The file is memory mapped and used in place:
+//			BinaryCatalogView doesn't parse or copy anything, record i is just a pointer into the mapping.
+//			The header and the arrays are found with a sfinae_binary_reader::BinaryReader (SFINAE.h), which checks them against the file.
+//			The format is little endian, as every platform this project targets. Other machines refuse to write or open it.
+//			Every record is validated once when the view opens (name inside the blob, valid enums), a corrupt file is rejected.
+
+namespace dp_SOLID_catalog_loader {
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_product_catalog::CatalogProduct;
+	using dp_SOLID_product_catalog::ProductCatalog;
+
+	//Read only memory mapping of a whole file.
+	class MappedFile {
+		const char* base{ nullptr };
+		size_t length{ 0 };
+#ifdef _WIN32
+		HANDLE file{ INVALID_HANDLE_VALUE };
+		HANDLE mapping{ nullptr };
+#endif
+
+		void release() noexcept {
+#ifdef _WIN32
+			if (base) UnmapViewOfFile(base);
+			if (mapping) CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+			if (base) ::munmap(const_cast<char*>(base), length);
+#endif
+		}
+
+	public:
+		explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+			file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("cannot open " + path.string());
+			try {
+				LARGE_INTEGER file_size;
+				if (!GetFileSizeEx(file, &file_size)) throw std::runtime_error("cannot stat " + path.string());
+				length = static_cast<size_t>(file_size.QuadPart);
+				if (length) {
+					mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					if (!mapping) throw std::runtime_error("cannot map " + path.string());
+					base = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					if (!base) throw std::runtime_error("cannot map " + path.string());
+				}
+			}
+			catch (...) {
+				release();	//The destructor doesn't run for a throwing constructor
+				throw;
+			}
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) throw std::runtime_error("cannot open " + path.string());
+			struct stat st;
+			if (::fstat(fd, &st) != 0) {
+				::close(fd);
+				throw std::runtime_error("cannot stat " + path.string());
+			}
+			length = static_cast<size_t>(st.st_size);
+			if (length) {
+				void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p == MAP_FAILED) {
+					::close(fd);
+					throw std::runtime_error("cannot map " + path.string());
+				}
+				::madvise(p, length, MADV_SEQUENTIAL);
+				base = static_cast<const char*>(p);
+			}
+			::close(fd);	//The mapping keeps the file alive
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() { release(); }
+
+		const char* data() const { return base; }
+		size_t size() const { return length; }
+	};
+
+	/********************** CSV *************************/
+
+	//The enum names come from their reflection tables (templates_enum_reflection): one perfect hash and one compare per field, case
+	//insensitive on the whole word, "red", "Red" and "RED" are all accepted.
+	template <typename E>
+	bool parse_enum(std::string_view text, E& out) {
+		const auto value = templates_enum_reflection::from_string<E>(text);
+		if (!value) return false;
+		out = *value;
+		return true;
+	}
+
+	struct RawRow {
+		std::string_view name;	//Points into the mapped file
+		Color color;
+		Size size;
+	};
+
+	struct ChunkResult {
+		std::vector<RawRow> rows;
+		size_t errors{ 0 };
+	};
+
+	//Parses [begin, end), which starts at the beginning of a line and ends right after a '\n' (or at the end of the file).
+	inline void parse_chunk(const char* begin, const char* end, ChunkResult& out) {
+		out.rows.reserve((end - begin) / 24);
+		const char* p = begin;
+		while (p < end) {
+			const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			if (!eol) eol = end;
+			const char* line_end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+
+			const char* c1 = static_cast<const char*>(std::memchr(p, ',', line_end - p));
+			const char* c2 = c1 ? static_cast<const char*>(std::memchr(c1 + 1, ',', line_end - c1 - 1)) : nullptr;
+			RawRow row;
+			if (c2 && parse_enum({ c1 + 1, static_cast<size_t>(c2 - c1 - 1) }, row.color)
+				&& parse_enum({ c2 + 1, static_cast<size_t>(line_end - c2 - 1) }, row.size)) {
+				row.name = { p, static_cast<size_t>(c1 - p) };
+				out.rows.push_back(row);
+			}
+			else if (line_end != p) {
+				++out.errors;	//Header line or malformed row
+			}
+			p = eol + 1;
+		}
+	}
+
+	struct LoadStats {
+		size_t rows{ 0 };
+		size_t errors{ 0 };
+		double seconds{ 0 };
+		double rows_per_second() const { return seconds > 0 ? rows / seconds : 0; }
+	};
+
+	inline LoadStats load_csv(const std::filesystem::path& path, ProductCatalog& catalog, unsigned threads = std::thread::hardware_concurrency()) {
+		auto start = std::chrono::steady_clock::now();
+		MappedFile file{ path };
+		const char* data = file.data();
+		const size_t size = file.size();
+		threads = std::max(1u, threads);
+
+		//Chunk boundaries, each moved forward to the start of the next line.
+		std::vector<const char*> bounds{ data };
+		for (unsigned t = 1; t < threads; ++t) {
+			const char* p = std::max(data + size * t / threads, bounds.back());
+			const char* eol = p < data + size ? static_cast<const char*>(std::memchr(p, '\n', data + size - p)) : nullptr;
+			bounds.push_back(eol ? eol + 1 : data + size);
+		}
+		bounds.push_back(data + size);
+
+		std::vector<ChunkResult> chunks(threads);
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threads; ++t) {
+			workers.emplace_back(parse_chunk, bounds[t], bounds[t + 1], std::ref(chunks[t]));
+		}
+		for (auto& w : workers) w.join();
+
+		LoadStats stats;
+		for (const auto& chunk : chunks) stats.rows += chunk.rows.size();
+		catalog.reserve(catalog.size() + stats.rows);
+		for (const auto& chunk : chunks) {
+			stats.errors += chunk.errors;
+			for (const auto& row : chunk.rows) catalog.add(row.name, row.color, row.size);
+		}
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	/********************** Binary *************************/
+
+	struct BinaryHeader {
+		char magic[8];				//"PRODCAT1"
+		std::uint64_t count;
+		std::uint64_t names_offset;	//From the start of the file
+		std::uint64_t names_size;
+	};
+
+	struct BinaryRecord {
+		std::uint32_t name_offset;	//Into the name blob
+		std::uint32_t name_length;
+		std::uint8_t color;
+		std::uint8_t size;
+		std::uint8_t padding[2];
+	};
+
+	constexpr char binary_magic[8]{ 'P', 'R', 'O', 'D', 'C', 'A', 'T', '1' };
+
+	//Names are written once per distinct content. The pointers of interned names don't identify them: an empty name takes no arena
+	//space and has the address of the next name interned after it.
+	inline void write_binary(const std::filesystem::path& path, const ProductCatalog& catalog) {
+		if constexpr (std::endian::native != std::endian::little) throw std::runtime_error("binary catalogs are little endian, this machine is not");
+		std::vector<BinaryRecord> records;
+		std::string names;
+		std::unordered_map<std::string_view, std::uint32_t> written;	//The views point into the catalog, which outlives the map
+		records.reserve(catalog.size());
+		for (const auto product : catalog.products()) {
+			auto [it, inserted] = written.emplace(std::string_view{ product->name }, static_cast<std::uint32_t>(names.size()));
+			if (inserted) names.append(product->name);
+			records.push_back(BinaryRecord{ it->second, static_cast<std::uint32_t>(product->name.size()),
+				static_cast<std::uint8_t>(product->color), static_cast<std::uint8_t>(product->size), {} });
+		}
+
+		BinaryHeader header{};
+		std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+		header.count = records.size();
+		header.names_offset = sizeof(BinaryHeader) + records.size() * sizeof(BinaryRecord);
+		header.names_size = names.size();
+
+		std::ofstream out{ path, std::ios::binary };
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BinaryRecord));
+		out.write(names.data(), names.size());
+		if (!out) throw std::runtime_error("cannot write " + path.string());
+	}
+
+	//Records are used in place, so the file has the byte order of the machine. Only little endian machines accept it.
+	using CatalogReader = sfinae_binary_reader::BinaryReader<std::endian::native>;
+
+	//Zero-copy access: the view owns the mapping and hands out pointers/string_views into it.
+	class BinaryCatalogView {
+		MappedFile file;
+		const BinaryRecord* records{ nullptr };
+		const char* names{ nullptr };
+		size_t count{ 0 };
+
+	public:
+		explicit BinaryCatalogView(const std::filesystem::path& path) : file{ path } {
+			if constexpr (std::endian::native != std::endian::little) throw std::runtime_error("binary catalogs are little endian, this machine is not");
+			if (file.size() < sizeof(BinaryHeader)) throw std::runtime_error("truncated catalog " + path.string());
+			CatalogReader reader{ file.data(), file.size() };
+			const auto header = reader.read<BinaryHeader>();
+			if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0) throw std::runtime_error("not a catalog " + path.string());
+			const auto corrupt = [&path] { return std::runtime_error("corrupt catalog " + path.string()); };
+			std::span<const BinaryRecord> all;
+			try {
+				//The reader checks the counts against the file, without overflowing on a corrupt count.
+				all = reader.read_span<BinaryRecord>(header.count);
+				if (reader.position() > header.names_offset) throw corrupt();
+				reader.seek(header.names_offset);
+				names = reader.read_span<char>(header.names_size).data();
+			}
+			catch (const std::exception&) {
+				throw corrupt();
+			}
+			//Every record once, here, so that name(), color() and size_of() can trust them.
+			for (const BinaryRecord& record : all) {
+				if (std::uint64_t{ record.name_offset } + record.name_length > header.names_size
+					|| record.color >= templates_enum_reflection::count_of<Color>
+					|| record.size >= templates_enum_reflection::count_of<Size>) {
+					throw corrupt();
+				}
+			}
+			records = all.data();
+			count = all.size();
+		}
+
+		size_t size() const { return count; }
+		std::string_view name(size_t i) const { return { names + records[i].name_offset, records[i].name_length }; }
+		Color color(size_t i) const { return static_cast<Color>(records[i].color); }
+		Size size_of(size_t i) const { return static_cast<Size>(records[i].size); }
+	};
+
+	//For code that wants a ProductCatalog (and its Specification support) rather than the view.
+	inline LoadStats load_binary(const std::filesystem::path& path, ProductCatalog& catalog) {
+		auto start = std::chrono::steady_clock::now();
+		BinaryCatalogView view{ path };
+		catalog.reserve(catalog.size() + view.size());
+		for (size_t i = 0; i < view.size(); ++i) catalog.add(view.name(i), view.color(i), view.size_of(i));
+		LoadStats stats;
+		stats.rows = view.size();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	void main() {
+		const auto dir = std::filesystem::temp_directory_path();
+		const auto csv_path = dir / "cpp_reference_catalog.csv";
+		const auto bin_path = dir / "cpp_reference_catalog.bin";
+		const char* colors[]{ "red", "green", "blue" };
+		const char* sizes[]{ "small", "medium", "large" };
+		{
+			std::ofstream csv{ csv_path };
+			csv << "name,color,size\n";
+			for (int i = 0; i < 3000000; ++i) {
+				csv << "Product " << i % 100000 << ',' << colors[i % 3] << ',' << sizes[(i / 3) % 3] << '\n';
+			}
+		}
+
+		ProductCatalog from_csv;
+		auto csv_stats = load_csv(csv_path, from_csv);
+		std::cout << "CSV:    " << csv_stats.rows << " rows (" << csv_stats.errors << " skipped) in " << csv_stats.seconds * 1000 << " ms, "
+			<< csv_stats.rows_per_second() / 1e6 << " M rows/s" << std::endl;
+
+		write_binary(bin_path, from_csv);
+
+		auto start = std::chrono::steady_clock::now();
+		size_t red = 0;
+		{
+			BinaryCatalogView view{ bin_path };
+			for (size_t i = 0; i < view.size(); ++i) red += view.color(i) == Color::red;
+		}
+		double view_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Binary: " << from_csv.size() << " rows mapped and scanned in " << view_seconds * 1000 << " ms, "
+			<< from_csv.size() / view_seconds / 1e6 << " M rows/s (" << red << " red)" << std::endl;
+
+		ProductCatalog from_binary;
+		auto bin_stats = load_binary(bin_path, from_binary);
+		std::cout << "Binary into ProductCatalog: " << bin_stats.rows << " rows in " << bin_stats.seconds * 1000 << " ms, "
+			<< bin_stats.rows_per_second() / 1e6 << " M rows/s" << std::endl;
+
+		//Round trip with an empty name (",red,small" is a valid CSV line) between other names.
+		ProductCatalog small;
+		for (const char* name : { "Apple", "", "Tree", "House" }) small.add(name, Color::red, Size::small);
+		write_binary(bin_path, small);
+		{
+			BinaryCatalogView view{ bin_path };
+			bool same = view.size() == small.size();
+			for (size_t i = 0; same && i < view.size(); ++i) same = view.name(i) == small.products()[i]->name;
+			std::cout << "Round trip with an empty name: " << (same ? "identical" : "DIFFERENT") << std::endl;
+		}
+
+		std::filesystem::remove(csv_path);
+		std::filesystem::remove(bin_path);
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <deque>
+#include <limits>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <chrono>
+#include <iostream>
+#include "dp_SOLID_OCP.h"
+
+//BetterFilter::filter() recomputes the answer from scratch on every call, even if only one product changed since the previous call.
+//A materialized view turns the problem around: the query is registered once ("standing query") and the collection keeps its result
+//up to date while products are inserted, updated and removed. Reading the result is then O(1), it is just a reference to a vector,
+//and a change to one product only re-evaluates that single product against the registered specifications.
+//https://en.wikipedia.org/wiki/Materialized_view
+
+namespace dp_SOLID_materialized_view {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::SizeSpec;
+	using dp_SOLID_Specification::BetterFilter;
+
+	class ProductCollection {
+	public:
+		using ProductId = size_t;
+		using QueryId = size_t;
+
+	private:
+		static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+		//Each result set is an unordered dense vector, position[] remembers where a product sits so that it can be swap-removed in O(1).
+		struct StandingQuery {
+			Specification<Product>* spec{ nullptr };
+			std::vector<Product*> results;
+			std::vector<ProductId> result_ids;
+			std::vector<size_t> position;	//Indexed by ProductId, npos if the product is not part of the result
+
+			void add(ProductId id, Product* p) {
+				if (position.size() <= id) position.resize(id + 1, npos);
+				position[id] = results.size();
+				results.push_back(p);
+				result_ids.push_back(id);
+			}
+
+			void erase(ProductId id) {
+				size_t pos = position[id];
+				results[pos] = results.back();
+				result_ids[pos] = result_ids.back();
+				position[result_ids[pos]] = pos;
+				results.pop_back();
+				result_ids.pop_back();
+				position[id] = npos;
+			}
+
+			bool contains(ProductId id) const {
+				return id < position.size() && position[id] != npos;
+			}
+		};
+
+		std::deque<Product> products;		//deque, so that Product* handed out in the results stay valid while the collection grows
+		std::vector<bool> alive;
+		std::vector<ProductId> free_ids;	//Slots of removed products are reused
+		std::vector<StandingQuery> queries;
+
+		//Removed ids are in free_ids already: updating or removing them again would resurrect a dead product or hand the id out twice.
+		void require_alive(ProductId id, const char* operation) const {
+			if (id >= alive.size() || !alive[id]) throw std::out_of_range(std::string{ "ProductCollection::" } + operation + ": no product with this id");
+		}
+
+		//Re-evaluates one product against every registered query.
+		void refresh(ProductId id) {
+			Product* p = &products[id];
+			for (auto& query : queries) {
+				if (!query.spec) continue;
+				bool match = query.spec->is_satisfied(p);
+				bool member = query.contains(id);
+				if (match && !member) query.add(id, p);
+				else if (!match && member) query.erase(id);
+			}
+		}
+
+	public:
+		ProductId insert(const Product& product) {
+			ProductId id;
+			if (!free_ids.empty()) {
+				id = free_ids.back();
+				free_ids.pop_back();
+				products[id] = product;
+				alive[id] = true;
+			}
+			else {
+				id = products.size();
+				products.push_back(product);
+				alive.push_back(true);
+			}
+			refresh(id);
+			return id;
+		}
+
+		void update(ProductId id, const Product& product) {
+			require_alive(id, "update");
+			products[id] = product;
+			refresh(id);
+		}
+
+		void remove(ProductId id) {
+			require_alive(id, "remove");
+			for (auto& query : queries) {
+				if (query.spec && query.contains(id)) query.erase(id);
+			}
+			alive[id] = false;
+			free_ids.push_back(id);
+		}
+
+		const Product& get(ProductId id) const {
+			require_alive(id, "get");
+			return products[id];
+		}
+
+		//The specification must outlive the registration. Building the initial result is the only full scan the query ever does.
+		QueryId register_query(Specification<Product>& spec) {
+			StandingQuery query;
+			query.spec = &spec;
+			for (ProductId id = 0; id < products.size(); ++id) {
+				if (alive[id] && spec.is_satisfied(&products[id])) query.add(id, &products[id]);
+			}
+			queries.push_back(std::move(query));
+			return queries.size() - 1;
+		}
+
+		void unregister_query(QueryId id) {
+			queries[id] = StandingQuery{};
+		}
+
+		//O(1), the result is already materialized. The order of the products is unspecified.
+		const std::vector<Product*>& results(QueryId id) const {
+			return queries[id].results;
+		}
+
+		std::vector<Product*> all() {
+			std::vector<Product*> items;
+			for (ProductId id = 0; id < products.size(); ++id) {
+				if (alive[id]) items.push_back(&products[id]);
+			}
+			return items;
+		}
+	};
+
+	void main() {
+		ProductCollection collection;
+		std::vector<ProductCollection::ProductId> ids;
+		for (int i = 0; i < 200000; ++i) {
+			ids.push_back(collection.insert(Product{ "Product " + std::to_string(i), static_cast<Color>(i % 3), static_cast<Size>((i / 3) % 3) }));
+		}
+
+		ColorSpec<Product> red{ Color::red };
+		SizeSpec<Product> large{ Size::large };
+		AndSpecification<Product> red_and_large{ red, large };
+
+		auto red_query = collection.register_query(red);
+		auto red_large_query = collection.register_query(red_and_large);
+		std::cout << "red: " << collection.results(red_query).size()
+			<< ", red and large: " << collection.results(red_large_query).size() << std::endl;
+
+		//The dashboard refreshes after every small change.
+		const int rounds = 1000;
+		auto start = std::chrono::steady_clock::now();
+		size_t seen = 0;
+		for (int i = 0; i < rounds; ++i) {
+			collection.update(ids[i], Product{ "Changed", Color::red, Size::large });
+			seen += collection.results(red_large_query).size();
+		}
+		auto incremental_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		auto items = collection.all();
+		start = std::chrono::steady_clock::now();
+		size_t recomputed = 0;
+		for (int i = 0; i < rounds / 100; ++i) {
+			recomputed += BetterFilter{}.filter(items, red_and_large).size();
+		}
+		auto recompute_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() * 100;
+
+		std::cout << rounds << " update + read rounds, materialized: " << incremental_us << " us (" << seen << " rows seen)" << std::endl;
+		std::cout << rounds << " recomputations with BetterFilter (extrapolated): " << recompute_us << " us" << std::endl;
+
+		collection.remove(ids[0]);
+		std::cout << "red and large after removing one product: " << collection.results(red_large_query).size()
+			<< " (BetterFilter: " << BetterFilter{}.filter(collection.all(), red_and_large).size() << ")" << std::endl;
+	}
+}
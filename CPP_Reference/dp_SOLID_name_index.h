@@ -0,0 +1,259 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include <type_traits>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "dp_SOLID_OCP.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DP_SOLID_NAME_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+//NameSpec with NameMatch::Prefix/Contains has to look at every product name. Two ways to make that fast:
+//	1. An index. NameIndex keeps the names sorted (prefix queries are one binary search) and a suffix array over all names
+//	   (every substring of a name is a prefix of one of its suffixes, so contains queries are a binary search as well).
+//	   https://en.wikipedia.org/wiki/Suffix_array
+//	2. A faster scan for when there is no index. simd_contains() compares the first AND the last character of the needle against
+//	   16 positions of the name at once and only calls memcmp where both match, which rejects almost every position for free.
+//	   http://0x80.pl/articles/simd-strfind.html
+//
+//IndexedNameSpec is a NameSpec, so it composes with AndSpecification like any other specification: the index lookup is done once
+//when the specification is created, is_satisfied() is then a binary search in the hits. The query planner also recognizes it and
+//intersects its hits with the other index buckets.
+
+namespace dp_SOLID_name_index {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::NameSpec;
+	using dp_SOLID_Specification::NameMatch;
+	using dp_SOLID_Specification::BetterFilter;
+
+	inline bool simd_contains(std::string_view haystack, std::string_view needle) {
+		const size_t n = needle.size();
+		if (n == 0) return true;
+		if (n > haystack.size()) return false;
+		const char* h = haystack.data();
+		const size_t last_start = haystack.size() - n;	//Last position a match can start at
+		size_t i = 0;
+
+#ifdef DP_SOLID_NAME_INDEX_SSE2
+		const __m128i first = _mm_set1_epi8(needle.front());
+		const __m128i last = _mm_set1_epi8(needle.back());
+		for (; i + 16 <= last_start + 1; i += 16) {
+			__m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+			__m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + n - 1));
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+			while (mask) {
+				unsigned bit = static_cast<unsigned>(std::countr_zero(mask));
+				if (std::memcmp(h + i + bit + 1, needle.data() + 1, n - 1) == 0) return true;
+				mask &= mask - 1;
+			}
+		}
+#endif
+		//Tail (or everything without SSE2): memchr finds the candidates for the first character.
+		while (i <= last_start) {
+			const char* p = static_cast<const char*>(std::memchr(h + i, needle.front(), last_start + 1 - i));
+			if (!p) return false;
+			i = p - h;
+			if (std::memcmp(p + 1, needle.data() + 1, n - 1) == 0) return true;
+			++i;
+		}
+		return false;
+	}
+
+	//Index over the names of a fixed list of items. Results are positions in that list, sorted ascending.
+	template <typename T>
+	class NameIndex {
+		std::vector<T*> items;
+		std::vector<std::uint32_t> by_name;		//Item positions sorted by name
+		std::string text;						//All names, each terminated by '\0'
+		std::vector<std::uint32_t> suffixes;	//Offsets into text, sorted by the suffix starting there
+		std::vector<std::uint32_t> owner;		//Offset into text -> item position
+		std::vector<std::uint32_t> name_end;	//Item position -> offset of its terminator in text
+
+		std::string_view name_of(std::uint32_t pos) const { return std::string_view{ items[pos]->name }; }
+		std::string_view suffix(std::uint32_t offset) const { return { text.data() + offset, name_end[owner[offset]] - offset }; }
+
+		static std::vector<size_t> sorted_unique(std::vector<size_t> positions) {
+			std::sort(positions.begin(), positions.end());
+			positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+			return positions;
+		}
+
+		//Prefix doubling (Manber-Myers) with counting sorts: after round k the suffixes are sorted by their first 2^k characters.
+		//O(n log n), a comparison sort would compare the long common parts of similar names over and over again.
+		static std::vector<std::uint32_t> build_suffix_array(const std::string& s) {
+			const size_t n = s.size();
+			std::vector<std::uint32_t> sa(n), rank(n), tmp(n);
+			std::vector<std::uint32_t> count(std::max<size_t>(256, n) + 1);
+			size_t classes = 256;	//Number of distinct ranks, the counting sorts only need that many buckets
+			if (n == 0) return sa;
+
+			for (size_t i = 0; i < n; ++i) rank[i] = static_cast<unsigned char>(s[i]);
+			for (size_t i = 0; i < n; ++i) ++count[rank[i]];
+			for (size_t r = 1; r < classes; ++r) count[r] += count[r - 1];
+			for (size_t i = n; i-- > 0;) sa[--count[rank[i]]] = static_cast<std::uint32_t>(i);
+
+			for (size_t k = 1;; k <<= 1) {
+				//Order by the second half first: suffixes without one come first, then the others in the current order.
+				size_t p = 0;
+				for (size_t i = n - std::min(k, n); i < n; ++i) tmp[p++] = static_cast<std::uint32_t>(i);
+				for (size_t j = 0; j < n; ++j) if (sa[j] >= k) tmp[p++] = static_cast<std::uint32_t>(sa[j] - k);
+
+				//Stable counting sort by the first half.
+				std::fill(count.begin(), count.begin() + classes, 0);
+				for (size_t i = 0; i < n; ++i) ++count[rank[i]];
+				for (size_t r = 1; r < classes; ++r) count[r] += count[r - 1];
+				for (size_t j = n; j-- > 0;) sa[--count[rank[tmp[j]]]] = tmp[j];
+
+				auto second = [&](std::uint32_t i) { return i + k < n ? static_cast<long long>(rank[i + k]) : -1ll; };
+				tmp[sa[0]] = 0;
+				classes = 1;
+				for (size_t j = 1; j < n; ++j) {
+					bool same = rank[sa[j]] == rank[sa[j - 1]] && second(sa[j]) == second(sa[j - 1]);
+					tmp[sa[j]] = static_cast<std::uint32_t>(same ? classes - 1 : classes++);
+				}
+				rank.swap(tmp);
+				if (classes == n) break;
+			}
+			return sa;
+		}
+
+	public:
+		explicit NameIndex(const std::vector<T*>& items_) : items{ items_ } {
+			by_name.resize(items.size());
+			for (std::uint32_t i = 0; i < items.size(); ++i) by_name[i] = i;
+			std::sort(by_name.begin(), by_name.end(), [&](auto a, auto b) { return name_of(a) < name_of(b); });
+
+			for (std::uint32_t i = 0; i < items.size(); ++i) {
+				auto name = name_of(i);
+				owner.insert(owner.end(), name.size() + 1, i);
+				text.append(name);
+				name_end.push_back(static_cast<std::uint32_t>(text.size()));
+				text.push_back('\0');
+			}
+
+			//The suffix array of the whole text orders the suffixes across the '\0' separators too. '\0' is the smallest character,
+			//hence that order is consistent with comparing suffixes cut at the end of their name, which is what the lookups do.
+			for (auto offset : build_suffix_array(text)) {
+				if (text[offset] != '\0') suffixes.push_back(offset);
+			}
+		}
+
+		std::vector<size_t> prefix(std::string_view p) const {
+			auto lower = std::lower_bound(by_name.begin(), by_name.end(), p,
+				[&](auto pos, std::string_view value) { return name_of(pos) < value; });
+			std::vector<size_t> positions;
+			for (auto it = lower; it != by_name.end() && name_of(*it).substr(0, p.size()) == p; ++it) positions.push_back(*it);
+			return sorted_unique(std::move(positions));
+		}
+
+		std::vector<size_t> contains(std::string_view p) const {
+			if (p.empty()) {
+				std::vector<size_t> all(items.size());
+				for (size_t i = 0; i < all.size(); ++i) all[i] = i;
+				return all;
+			}
+			//All suffixes starting with p are adjacent in the suffix array.
+			auto range = std::equal_range(suffixes.begin(), suffixes.end(), p, [&](const auto& a, const auto& b) {
+				if constexpr (std::is_same_v<std::decay_t<decltype(a)>, std::string_view>) return a < suffix(b).substr(0, a.size());
+				else return suffix(a).substr(0, b.size()) < b;
+			});
+			std::vector<size_t> positions;
+			for (auto it = range.first; it != range.second; ++it) positions.push_back(owner[*it]);
+			return sorted_unique(std::move(positions));
+		}
+
+		std::vector<size_t> lookup(std::string_view p, NameMatch match) const {
+			switch (match) {
+			case NameMatch::Prefix: return prefix(p);
+			case NameMatch::Contains: return contains(p);
+			default: {
+				auto hits = prefix(p);
+				hits.erase(std::remove_if(hits.begin(), hits.end(), [&](size_t pos) { return name_of(static_cast<std::uint32_t>(pos)) != p; }), hits.end());
+				return hits;
+			}
+			}
+		}
+
+		const std::vector<T*>& indexed_items() const { return items; }
+	};
+
+	//A NameSpec answered by a NameIndex. Without an index it falls back to a scan using simd_contains().
+	template <typename T>
+	class IndexedNameSpec : public NameSpec<T> {
+		const NameIndex<T>* index;
+		std::vector<size_t> hit_positions;	//Positions in the indexed list, sorted
+		std::vector<T*> hits;				//Sorted by address for is_satisfied()
+
+	public:
+		IndexedNameSpec(const NameIndex<T>& idx, std::string name, NameMatch match)
+			: NameSpec<T>{ std::move(name), match }, index{ &idx } {
+			hit_positions = idx.lookup(this->get_name(), match);
+			for (auto pos : hit_positions) hits.push_back(idx.indexed_items()[pos]);
+			std::sort(hits.begin(), hits.end());
+		}
+
+		IndexedNameSpec(std::string name, NameMatch match) : NameSpec<T>{ std::move(name), match }, index{ nullptr } {}
+
+		bool is_satisfied(T* item) override {
+			if (index) return std::binary_search(hits.begin(), hits.end(), item);
+
+			std::string_view item_name{ item->name };
+			if (this->get_match() == NameMatch::Contains) return simd_contains(item_name, this->get_name());
+			return NameSpec<T>::is_satisfied(item);
+		}
+
+		bool has_index() const { return index != nullptr; }
+		const std::vector<size_t>& positions() const { return hit_positions; }
+		const std::vector<T*>& matches() const { return hits; }
+	};
+
+	void main() {
+		const char* words[]{ "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel", "india", "juliet" };
+		std::vector<Product> storage;
+		for (int i = 0; i < 50000; ++i) {
+			std::string name = std::string{ "Deluxe " } + words[i % 10] + " " + words[(i / 10) % 10] + " edition with extra long description " + std::to_string(i);
+			storage.push_back(Product{ name, static_cast<Color>(i % 3), static_cast<Size>((i / 3) % 3) });
+		}
+		std::vector<Product*> products;
+		for (auto& p : storage) products.push_back(&p);
+
+		auto start = std::chrono::steady_clock::now();
+		NameIndex<Product> index{ products };
+		auto build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Index over " << products.size() << " names built in " << build_ms << " ms" << std::endl;
+
+		ColorSpec<Product> red{ Color::red };
+		auto run = [&](const char* label, Specification<Product>& name_spec, const std::vector<Product*>& candidates) {
+			AndSpecification<Product> query{ name_spec, red };
+			auto begin = std::chrono::steady_clock::now();
+			auto found = BetterFilter{}.filter(candidates, query).size();
+			auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+			std::cout << label << found << " red products in " << us << " us" << std::endl;
+		};
+
+		NameSpec<Product> plain{ "hotel echo", NameMatch::Contains };
+		IndexedNameSpec<Product> simd_scan{ "hotel echo", NameMatch::Contains };
+		IndexedNameSpec<Product> indexed{ index, "hotel echo", NameMatch::Contains };
+		IndexedNameSpec<Product> prefix{ index, "Deluxe golf d", NameMatch::Prefix };
+
+		run("contains, std::string_view::find scan: ", plain, products);
+		run("contains, SIMD prefilter scan:         ", simd_scan, products);
+		//The index hits are the candidates, the AndSpecification checks the remaining predicates on them only.
+		run("contains, suffix array hits && red:    ", indexed, indexed.matches());
+		run("prefix, sorted names hits && red:      ", prefix, prefix.matches());
+	}
+}
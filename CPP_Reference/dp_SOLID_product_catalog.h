@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include "dp_SOLID_OCP.h"
+#include "ds_arena.h"
+
+//dp_SOLID_Specification::Product owns its name in a std::string and every product is created with its own new.
+//For a catalog of millions of products that means millions of small allocations (two per product once the name is too long for the
+//small string buffer), and the same names are stored over and over again.
+//The catalog below stores the records contiguously in an ObjectArena and the names in a StringPool, so every distinct name is stored once
+//and the record only keeps a string_view into the pool. All memory belongs to the catalog and is released together with it.
+//CatalogProduct has the same members as Product, hence ColorSpec<CatalogProduct>, SizeSpec<CatalogProduct>, NameSpec<CatalogProduct> work as is.
+
+namespace dp_SOLID_product_catalog {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::SizeSpec;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::Filter;
+
+	struct CatalogProduct {
+		std::string_view name;	//Points into the StringPool of the owning catalog
+		Color color;
+		Size size;
+	};
+
+	class ProductCatalog {
+		ds_arena::StringPool names;
+		ds_arena::ObjectArena<CatalogProduct> records;
+		std::vector<CatalogProduct*> items;
+
+	public:
+		ProductCatalog() = default;
+		ProductCatalog(const ProductCatalog&) = delete;
+		ProductCatalog& operator=(const ProductCatalog&) = delete;
+
+		CatalogProduct* add(std::string_view name, Color color, Size size) {
+			auto record = records.emplace(names.view(names.intern(name)), color, size);
+			items.push_back(record);
+			return record;
+		}
+
+		void reserve(size_t count) { items.reserve(count); }
+
+		const std::vector<CatalogProduct*>& products() const { return items; }
+		size_t size() const { return items.size(); }
+		size_t distinct_names() const { return names.size(); }
+		size_t bytes_reserved() const {
+			return names.bytes_reserved() + records.bytes_reserved() + items.capacity() * sizeof(CatalogProduct*);
+		}
+	};
+
+	std::ostream& operator<<(std::ostream& os, const CatalogProduct& prod) {
+		os << "Name = " << prod.name << ", Color = " << prod.color << ", size = " << prod.size << '\n';
+		return os;
+	}
+
+	//Same as BetterFilter, for the catalog records.
+	class CatalogFilter : public Filter<CatalogProduct> {
+	public:
+		std::vector<CatalogProduct*> filter(std::vector<CatalogProduct*> items, Specification<CatalogProduct>& spec) override {
+			std::vector<CatalogProduct*> filtered_products;
+			for (const auto& item : items) {
+				if (spec.is_satisfied(item)) {
+					filtered_products.push_back(item);
+				}
+			}
+			return filtered_products;
+		}
+	};
+
+	void main() {
+		const int count = 2000000;
+		auto name_of = [](int i) { return "Catalog product number " + std::to_string(i % 50000); };
+
+		auto start = std::chrono::steady_clock::now();
+		{
+			std::vector<Product*> products;
+			for (int i = 0; i < count; ++i) {
+				products.push_back(new Product{ name_of(i), static_cast<Color>(i % 3), static_cast<Size>((i / 3) % 3) });
+			}
+			for (auto p : products) delete p;
+		}
+		auto heap_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		//One new for the Product plus one for every name that doesn't fit into the small string buffer.
+		size_t heap_bytes = count * (sizeof(Product) + sizeof(Product*) + name_of(0).size() + 1);
+
+		start = std::chrono::steady_clock::now();
+		size_t arena_bytes = 0, distinct = 0, red_large = 0;
+		{
+			ProductCatalog catalog;
+			catalog.reserve(count);
+			for (int i = 0; i < count; ++i) {
+				catalog.add(name_of(i), static_cast<Color>(i % 3), static_cast<Size>((i / 3) % 3));
+			}
+			arena_bytes = catalog.bytes_reserved();
+			distinct = catalog.distinct_names();
+
+			ColorSpec<CatalogProduct> red{ Color::red };
+			SizeSpec<CatalogProduct> large{ Size::large };
+			AndSpecification<CatalogProduct> red_and_large{ red, large };
+			red_large = CatalogFilter{}.filter(catalog.products(), red_and_large).size();
+		}
+		auto arena_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "new Product:     " << count << " products, ~" << heap_bytes / (1 << 20) << " MiB payload, "
+			<< 2 * count << " allocations, " << heap_ms << " ms (load + free)" << std::endl;
+		std::cout << "ProductCatalog:  " << count << " products, " << distinct << " distinct names, " << arena_bytes / (1 << 20)
+			<< " MiB reserved, " << arena_ms << " ms (load + filter + free), " << red_large << " red and large" << std::endl;
+	}
+}
@@ -0,0 +1,443 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <array>
+#include <memory>
+#include <string_view>
+#include <cctype>
+#include <unordered_map>
+#include "dp_SOLID_OCP.h"
+#include "dp_SOLID_name_index.h"
+#include "templates_enum_reflection.h"
+
+//AndSpecification/OrSpecification from dp_SOLID_Specification always evaluate "left" before "right", in the order the user wrote them.
+//That is fine for two cheap predicates, but once specifications are composed from many parts the order matters a lot:
+//a conjunction should first run the predicate that is cheap AND rejects most items, a disjunction the one that accepts most items.
+//The planner below is a tiny version of what a database query optimizer does:
+//	1. Flatten the nested And/Or tree into n-ary nodes (((a && b) && c) becomes AND(a, b, c)).
+//	2. Keep selectivity (fraction of items that pass) and cost (ns per evaluation) statistics for every leaf specification.
+//	   They are sampled up front and then maintained incrementally while queries run.
+//	3. Order the children of every node by rank. For AND the classic rank is cost / (1 - selectivity), for OR it is cost / selectivity.
+//	4. For the top level conjuncts choose an access path: scan everything, or start from an index bucket (all products of one color/size, or
+//	   the hits of an IndexedNameSpec).
+//	5. explain() prints the chosen plan, like EXPLAIN in SQL.
+//https://en.wikipedia.org/wiki/Query_optimization
+
+namespace dp_SOLID_query_planner {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::OrSpecification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::SizeSpec;
+	using dp_SOLID_Specification::BetterFilter;
+	using dp_SOLID_Specification::NameSpec;
+	using dp_SOLID_name_index::IndexedNameSpec;
+
+	struct SpecStats {
+		size_t evaluated{ 0 };
+		size_t passed{ 0 };
+		double cost_ns{ 1.0 };	//Only updated when sampling, timing every single call would cost more than the predicates themselves.
+
+		//Without any observation we assume that half of the items pass.
+		double selectivity() const { return evaluated ? static_cast<double>(passed) / evaluated : 0.5; }
+
+		void record(bool ok) {
+			++evaluated;
+			passed += ok;
+		}
+	};
+
+	//Statistics are kept per specification object, so the same ColorSpec used in many queries shares its numbers.
+	//Plans share them too, a plan keeps updating (and owning) its statistics after the planner is gone.
+	class StatsRegistry {
+		std::unordered_map<const Specification<Product>*, std::shared_ptr<SpecStats>> stats;
+	public:
+		const std::shared_ptr<SpecStats>& operator[](const Specification<Product>* spec) {
+			auto& entry = stats[spec];
+			if (!entry) entry = std::make_shared<SpecStats>();
+			return entry;
+		}
+	};
+
+	//Secondary indices over a product list. Buckets hold positions in the original list, hence they are sorted and can be intersected with a merge.
+	class ProductIndex {
+		static constexpr size_t color_count = static_cast<size_t>(Color::blue) + 1;
+		static constexpr size_t size_count = static_cast<size_t>(Size::large) + 1;
+
+		std::vector<size_t> by_color[color_count];
+		std::vector<size_t> by_size[size_count];
+	public:
+		explicit ProductIndex(const std::vector<Product*>& items) {
+			for (size_t i = 0; i < items.size(); ++i) {
+				by_color[static_cast<size_t>(items[i]->color)].push_back(i);
+				by_size[static_cast<size_t>(items[i]->size)].push_back(i);
+			}
+		}
+
+		//Returns the bucket that answers the specification, or nullptr if the specification is not indexed.
+		const std::vector<size_t>* lookup(Specification<Product>& spec) const {
+			if (auto color_spec = dynamic_cast<ColorSpec<Product>*>(&spec)) {
+				return &by_color[static_cast<size_t>(color_spec->get_color())];
+			}
+			if (auto size_spec = dynamic_cast<SizeSpec<Product>*>(&spec)) {
+				return &by_size[static_cast<size_t>(size_spec->get_size())];
+			}
+			//The name index carries its own hits. They are positions in the list the NameIndex was built over, which has to be the same list.
+			if (auto name_spec = dynamic_cast<IndexedNameSpec<Product>*>(&spec); name_spec && name_spec->has_index()) {
+				return &name_spec->positions();
+			}
+			return nullptr;
+		}
+	};
+
+	enum class NodeKind { Leaf, And, Or };
+	constexpr std::array<std::string_view, 3> enum_names(NodeKind) { return { "FILTER", "AND", "OR" }; }
+	std::ostream& operator<<(std::ostream& os, NodeKind kind) {
+		return templates_enum_reflection::write(os, kind);
+	}
+
+	enum class AccessPath { Scan, Index };
+	constexpr std::array<std::string_view, 2> enum_names(AccessPath) { return { "scan", "index" }; }
+	std::ostream& operator<<(std::ostream& os, AccessPath access) {
+		return templates_enum_reflection::write(os, access);
+	}
+
+	struct PlanNode {
+		NodeKind kind{ NodeKind::Leaf };
+		Specification<Product>* spec{ nullptr };	//Leaf only
+		std::shared_ptr<SpecStats> stats;			//Leaf only
+		std::vector<PlanNode> children;
+
+		AccessPath access{ AccessPath::Scan };
+		const std::vector<size_t>* index{ nullptr };	//Set when access == AccessPath::Index
+
+		double selectivity{ 0.5 };
+		double cost{ 1.0 };	//Expected ns per item reaching this node
+	};
+
+	//A plan refers to the specifications and to the index buckets it was planned with, they have to outlive it. The statistics are shared
+	//with the planner, the plan may outlive the planner.
+	class QueryPlan {
+		PlanNode root;
+		size_t item_count;
+
+		//Assumed cost of touching one entry of an index bucket while merging, in ns.
+		static constexpr double index_entry_cost = 0.5;
+
+		friend class QueryPlanner;
+
+		static bool evaluate(const PlanNode& node, Product* item) {
+			switch (node.kind) {
+			case NodeKind::Leaf: {
+				bool ok = node.spec->is_satisfied(item);
+				node.stats->record(ok);
+				return ok;
+			}
+			case NodeKind::And:
+				for (const auto& child : node.children) {
+					if (child.access == AccessPath::Scan && !evaluate(child, item)) {
+						return false;
+					}
+				}
+				return true;
+			case NodeKind::Or:
+				for (const auto& child : node.children) {
+					if (evaluate(child, item)) {
+						return true;
+					}
+				}
+				return false;
+			}
+			return false;
+		}
+
+		static std::vector<size_t> intersect(const std::vector<size_t>& a, const std::vector<size_t>& b) {
+			std::vector<size_t> out;
+			std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+			return out;
+		}
+
+		static void describe(std::ostream& os, Specification<Product>& spec) {
+			if (auto color_spec = dynamic_cast<ColorSpec<Product>*>(&spec)) {
+				os << "color == " << color_spec->get_color();
+			}
+			else if (auto size_spec = dynamic_cast<SizeSpec<Product>*>(&spec)) {
+				os << "size == " << size_spec->get_size();
+			}
+			else if (auto name_spec = dynamic_cast<NameSpec<Product>*>(&spec)) {
+				os << "name " << name_spec->get_match() << " \"" << name_spec->get_name() << "\"";
+			}
+			else {
+				os << "custom predicate";	//Specification has no way to describe itself
+			}
+		}
+
+		static void explain_node(std::ostream& os, const PlanNode& node, int depth) {
+			os << std::string(depth * 2, ' ');
+			os << node.kind;
+			if (node.kind == NodeKind::Leaf) {
+				os << ' ';
+				describe(os, *node.spec);
+			}
+			if (node.access == AccessPath::Index) {
+				os << " [" << node.access << ", " << node.index->size() << " rows]";
+			}
+			os << " (selectivity " << node.selectivity << ", cost " << node.cost << " ns)\n";
+			for (const auto& child : node.children) {
+				explain_node(os, child, depth + 1);
+			}
+		}
+
+	public:
+		std::vector<Product*> execute(const std::vector<Product*>& items) const {
+			std::vector<Product*> result;
+
+			//Index driven: intersect the chosen buckets, then run the residual conjuncts on the survivors only.
+			std::vector<size_t> candidates;
+			bool use_index = false;
+			auto add_index = [&](const PlanNode& node) {
+				candidates = use_index ? intersect(candidates, *node.index) : *node.index;
+				use_index = true;
+			};
+			if (root.access == AccessPath::Index) {
+				add_index(root);
+			}
+			for (const auto& child : root.children) {
+				if (child.access == AccessPath::Index) {
+					add_index(child);
+				}
+			}
+
+			if (use_index) {
+				if (root.kind == NodeKind::Leaf) {
+					for (auto pos : candidates) result.push_back(items[pos]);
+					return result;
+				}
+				for (auto pos : candidates) {
+					if (evaluate(root, items[pos])) result.push_back(items[pos]);
+				}
+				return result;
+			}
+
+			for (const auto& item : items) {
+				if (evaluate(root, item)) result.push_back(item);
+			}
+			return result;
+		}
+
+		std::string explain() const {
+			std::ostringstream oss;
+			oss << "PLAN over " << item_count << " products, estimated "
+				<< root.cost * item_count << " ns\n";
+			explain_node(oss, root, 1);
+			return oss.str();
+		}
+	};
+
+	class QueryPlanner {
+		StatsRegistry stats;
+		const ProductIndex* index{ nullptr };
+
+		PlanNode flatten(Specification<Product>& spec) {
+			PlanNode node;
+			Specification<Product>* operands[2]{};
+			if (auto and_spec = dynamic_cast<AndSpecification<Product>*>(&spec)) {
+				node.kind = NodeKind::And;
+				operands[0] = &and_spec->lhs();
+				operands[1] = &and_spec->rhs();
+			}
+			else if (auto or_spec = dynamic_cast<OrSpecification<Product>*>(&spec)) {
+				node.kind = NodeKind::Or;
+				operands[0] = &or_spec->lhs();
+				operands[1] = &or_spec->rhs();
+			}
+			else {
+				node.spec = &spec;
+				node.stats = stats[&spec];
+				return node;
+			}
+
+			for (auto operand : operands) {
+				PlanNode child = flatten(*operand);
+				if (child.kind == node.kind) {	//AND(AND(a, b), c) == AND(a, b, c)
+					for (auto& grand_child : child.children) node.children.push_back(std::move(grand_child));
+				}
+				else {
+					node.children.push_back(std::move(child));
+				}
+			}
+			return node;
+		}
+
+		//Bottom-up: estimate every leaf, sort the children by rank and derive the estimate of the parent.
+		static void order(PlanNode& node) {
+			if (node.kind == NodeKind::Leaf) {
+				node.selectivity = node.stats->selectivity();
+				node.cost = node.stats->cost_ns;
+				return;
+			}
+			for (auto& child : node.children) order(child);
+
+			const bool is_and = node.kind == NodeKind::And;
+			auto rank = [is_and](const PlanNode& n) {
+				double drop = is_and ? 1.0 - n.selectivity : n.selectivity;
+				return n.cost / std::max(drop, 1e-9);
+			};
+			std::stable_sort(node.children.begin(), node.children.end(),
+				[&](const PlanNode& a, const PlanNode& b) { return rank(a) < rank(b); });
+
+			//A child only runs if all previous children passed (AND) or all previous children failed (OR).
+			double reach = 1.0;
+			node.cost = 0.0;
+			for (const auto& child : node.children) {
+				node.cost += reach * child.cost;
+				reach *= is_and ? child.selectivity : 1.0 - child.selectivity;
+			}
+			node.selectivity = is_and ? reach : 1.0 - reach;
+		}
+
+		//Only the top level conjuncts can drive the query from an index. Each indexed conjunct is compared against its scan alternative:
+		//the first bucket replaces a full scan, every further bucket must be cheaper to merge than to check as a residual filter.
+		void choose_access_paths(PlanNode& root, size_t item_count) const {
+			if (!index) return;
+
+			if (root.kind == NodeKind::Leaf) {
+				if (auto bucket = index->lookup(*root.spec)) {
+					if (bucket->size() * QueryPlan::index_entry_cost < item_count * root.cost) {
+						root.access = AccessPath::Index;
+						root.index = bucket;
+					}
+				}
+				return;
+			}
+			if (root.kind != NodeKind::And) return;
+
+			double rows = static_cast<double>(item_count);
+			double residual_cost = root.cost;
+			bool driven = false;
+
+			//Smallest buckets first, they shrink the candidate set the most.
+			std::vector<PlanNode*> indexed;
+			for (auto& child : root.children) {
+				if (child.kind == NodeKind::Leaf && index->lookup(*child.spec)) indexed.push_back(&child);
+			}
+			std::sort(indexed.begin(), indexed.end(), [&](PlanNode* a, PlanNode* b) {
+				return index->lookup(*a->spec)->size() < index->lookup(*b->spec)->size();
+			});
+
+			for (auto child : indexed) {
+				auto bucket = index->lookup(*child->spec);
+				double merge_cost = (bucket->size() + (driven ? rows : 0.0)) * QueryPlan::index_entry_cost;
+				double new_rows = driven ? rows * child->selectivity : static_cast<double>(bucket->size());
+				double with_index = merge_cost + new_rows * (residual_cost - child->cost);
+				double without_index = (driven ? 0.0 : item_count * QueryPlan::index_entry_cost) + rows * residual_cost;
+				if (with_index < without_index) {
+					child->access = AccessPath::Index;
+					child->index = bucket;
+					residual_cost -= child->cost;
+					rows = new_rows;
+					driven = true;
+				}
+			}
+		}
+
+	public:
+		QueryPlanner() = default;
+		explicit QueryPlanner(const ProductIndex& idx) : index{ &idx } {}
+
+		//Evaluates every leaf of the specification on (at most) sample_size items to seed selectivity and cost.
+		void sample(Specification<Product>& spec, const std::vector<Product*>& items, size_t sample_size = 1024) {
+			PlanNode node = flatten(spec);
+			sample_node(node, items, std::min(sample_size, items.size()));
+		}
+
+		QueryPlan plan(Specification<Product>& spec, size_t item_count) {
+			QueryPlan query;
+			query.item_count = item_count;
+			query.root = flatten(spec);
+			order(query.root);
+			choose_access_paths(query.root, item_count);
+			return query;
+		}
+
+	private:
+		void sample_node(const PlanNode& node, const std::vector<Product*>& items, size_t count) {
+			if (node.kind != NodeKind::Leaf) {
+				for (const auto& child : node.children) sample_node(child, items, count);
+				return;
+			}
+			if (count == 0) return;
+
+			//Sample evenly across the list, not just the head of it.
+			const size_t step = items.size() / count;
+			size_t passed = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < count; ++i) {
+				passed += node.spec->is_satisfied(items[i * step]);
+			}
+			auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			node.stats->evaluated += count;
+			node.stats->passed += passed;
+			node.stats->cost_ns = std::max(elapsed / count, 0.1);
+		}
+	};
+
+	//A deliberately expensive predicate so that the planner has something to reorder.
+	template <typename T>
+	class ExpensiveNameSpec : public Specification<T> {
+		std::string needle;
+	public:
+		ExpensiveNameSpec(std::string n) : needle{ std::move(n) } {}
+		bool is_satisfied(T* item) override {
+			std::string lowered = item->name;
+			std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return lowered.find(needle) != std::string::npos;
+		}
+	};
+
+	void main() {
+		std::vector<Product> storage;
+		for (int i = 0; i < 100000; ++i) {
+			storage.push_back(Product{ "Product " + std::to_string(i), static_cast<Color>(i % 3), static_cast<Size>((i / 3) % 3) });
+		}
+		std::vector<Product*> products;
+		for (auto& p : storage) products.push_back(&p);
+
+		ExpensiveNameSpec<Product> name_has_7{ "7" };
+		ColorSpec<Product> red{ Color::red };
+		SizeSpec<Product> large{ Size::large };
+		SizeSpec<Product> small{ Size::small };
+
+		//Written in the worst possible order: the expensive predicate first.
+		AndSpecification<Product> name_and_red{ name_has_7, red };
+		OrSpecification<Product> large_or_small{ large, small };
+		AndSpecification<Product> query{ name_and_red, large_or_small };
+
+		ProductIndex index{ products };
+		QueryPlanner planner{ index };
+		planner.sample(query, products);
+
+		auto plan = planner.plan(query, products.size());
+		std::cout << plan.explain() << std::endl;
+
+		auto start = std::chrono::steady_clock::now();
+		auto naive = BetterFilter{}.filter(products, query);
+		auto naive_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		auto planned = plan.execute(products);
+		auto planned_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "BetterFilter: " << naive.size() << " products in " << naive_us << " us" << std::endl;
+		std::cout << "Planned:      " << planned.size() << " products in " << planned_us << " us" << std::endl;
+	}
+}
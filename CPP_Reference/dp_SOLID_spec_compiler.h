@@ -0,0 +1,250 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <bit>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include "dp_SOLID_OCP.h"
+
+//Specifications built at runtime (for example from a search box) are trees of heap objects, and evaluating them means one virtual call
+//per node and per product. The compiler below lowers such a tree into a flat postfix program ("bytecode"), like a calculator in RPN:
+//	(color == red && size == large) || !(name == "X")   =>   COLOR_EQ 0, SIZE_EQ 0, AND, NAME_EQ 0, NOT, OR
+//The interpreter does not run the program per product but per block of 64 products. Every instruction works on a whole column of the
+//block and produces a 64 bit mask, so there is one dispatch per instruction and block instead of one virtual call per node and product.
+//
+//Prefix/contains name matches are left to the specification itself (Opaque), they may be backed by an index (dp_SOLID_name_index).
+//The program only depends on the *shape* of the query, the constants (which color, which size, which name) live in a separate binding
+//table and the instructions refer to them by slot. Hence all queries of the same shape share one compiled program from the cache.
+
+namespace dp_SOLID_spec_compiler {
+	using dp_SOLID_Specification::Product;
+	using dp_SOLID_Specification::Color;
+	using dp_SOLID_Specification::Size;
+	using dp_SOLID_Specification::Specification;
+	using dp_SOLID_Specification::AndSpecification;
+	using dp_SOLID_Specification::OrSpecification;
+	using dp_SOLID_Specification::NotSpecification;
+	using dp_SOLID_Specification::ColorSpec;
+	using dp_SOLID_Specification::SizeSpec;
+	using dp_SOLID_Specification::NameSpec;
+	using dp_SOLID_Specification::NameMatch;
+	using dp_SOLID_Specification::BetterFilter;
+
+	enum class Opcode : std::uint8_t { ColorEq, SizeEq, NameEq, Opaque, And, Or, Not };
+
+	struct Instruction {
+		Opcode op;
+		std::uint16_t slot;	//Index into the binding table of the leaf kind, unused by And/Or/Not
+	};
+
+	struct Program {
+		std::vector<Instruction> code;
+		size_t max_depth{ 0 };
+		bool uses_names{ false };
+	};
+
+	//The constants of one concrete query, in the order the leaves appear in the program.
+	struct Bindings {
+		std::vector<std::uint8_t> colors;
+		std::vector<std::uint8_t> sizes;
+		std::vector<std::string> names;
+		std::vector<Specification<Product>*> opaque;	//Specifications the compiler doesn't know, they are still called virtually
+	};
+
+	class CompiledQuery {
+		static constexpr size_t block_size = 64;
+
+		std::shared_ptr<const Program> program;
+		Bindings bindings;
+
+		friend class SpecCompiler;
+
+		template <typename Column, typename Value>
+		static std::uint64_t equal_mask(const Column& column, size_t count, const Value& value) {
+			std::uint64_t mask = 0;
+			for (size_t i = 0; i < count; ++i) {
+				mask |= static_cast<std::uint64_t>(column[i] == value) << i;
+			}
+			return mask;
+		}
+
+	public:
+		std::vector<Product*> filter(const std::vector<Product*>& items) const {
+			std::vector<Product*> result;
+			std::vector<std::uint64_t> stack(program->max_depth);
+			std::uint8_t colors[block_size];
+			std::uint8_t sizes[block_size];
+			std::string_view names[block_size];
+
+			for (size_t begin = 0; begin < items.size(); begin += block_size) {
+				const size_t count = std::min(block_size, items.size() - begin);
+				const std::uint64_t valid = count == block_size ? ~0ull : (1ull << count) - 1;
+				Product* const* block = items.data() + begin;
+
+				for (size_t i = 0; i < count; ++i) {
+					colors[i] = static_cast<std::uint8_t>(block[i]->color);
+					sizes[i] = static_cast<std::uint8_t>(block[i]->size);
+				}
+				if (program->uses_names) {
+					for (size_t i = 0; i < count; ++i) names[i] = block[i]->name;
+				}
+
+				size_t top = 0;
+				for (const auto& ins : program->code) {
+					switch (ins.op) {
+					case Opcode::ColorEq: stack[top++] = equal_mask(colors, count, bindings.colors[ins.slot]); break;
+					case Opcode::SizeEq: stack[top++] = equal_mask(sizes, count, bindings.sizes[ins.slot]); break;
+					case Opcode::NameEq: stack[top++] = equal_mask(names, count, std::string_view{ bindings.names[ins.slot] }); break;
+					case Opcode::Opaque: {
+						std::uint64_t mask = 0;
+						for (size_t i = 0; i < count; ++i) {
+							mask |= static_cast<std::uint64_t>(bindings.opaque[ins.slot]->is_satisfied(block[i])) << i;
+						}
+						stack[top++] = mask;
+						break;
+					}
+					case Opcode::And: --top; stack[top - 1] &= stack[top]; break;
+					case Opcode::Or: --top; stack[top - 1] |= stack[top]; break;
+					case Opcode::Not: stack[top - 1] = ~stack[top - 1] & valid; break;
+					}
+				}
+
+				for (std::uint64_t mask = stack[0]; mask; mask &= mask - 1) {
+					result.push_back(block[std::countr_zero(mask)]);
+				}
+			}
+			return result;
+		}
+
+		const Program& code() const { return *program; }
+	};
+
+	class SpecCompiler {
+		std::unordered_map<std::string, std::shared_ptr<const Program>> cache;
+		size_t hits{ 0 };
+		size_t misses{ 0 };
+
+		//One walk over the tree produces the shape key (the postfix program without its constants) and the bindings.
+		static void linearize(Specification<Product>& spec, std::string& shape, Bindings& bindings) {
+			if (auto color_spec = dynamic_cast<ColorSpec<Product>*>(&spec)) {
+				shape += 'C';
+				bindings.colors.push_back(static_cast<std::uint8_t>(color_spec->get_color()));
+			}
+			else if (auto size_spec = dynamic_cast<SizeSpec<Product>*>(&spec)) {
+				shape += 'S';
+				bindings.sizes.push_back(static_cast<std::uint8_t>(size_spec->get_size()));
+			}
+			else if (auto name_spec = dynamic_cast<NameSpec<Product>*>(&spec); name_spec && name_spec->get_match() == NameMatch::Exact) {
+				shape += 'N';
+				bindings.names.push_back(name_spec->get_name());
+			}
+			else if (auto not_spec = dynamic_cast<NotSpecification<Product>*>(&spec)) {
+				linearize(not_spec->operand(), shape, bindings);
+				shape += '!';
+			}
+			else if (auto and_spec = dynamic_cast<AndSpecification<Product>*>(&spec)) {
+				linearize(and_spec->lhs(), shape, bindings);
+				linearize(and_spec->rhs(), shape, bindings);
+				shape += '&';
+			}
+			else if (auto or_spec = dynamic_cast<OrSpecification<Product>*>(&spec)) {
+				linearize(or_spec->lhs(), shape, bindings);
+				linearize(or_spec->rhs(), shape, bindings);
+				shape += '|';
+			}
+			else {
+				shape += 'O';
+				bindings.opaque.push_back(&spec);
+			}
+		}
+
+		//Only done on a cache miss: assign slots, drop double negations and compute the stack depth the interpreter needs.
+		static std::shared_ptr<const Program> build(const std::string& shape) {
+			auto program = std::make_shared<Program>();
+			std::uint16_t next_color = 0, next_size = 0, next_name = 0, next_opaque = 0;
+			size_t depth = 0;
+			for (char c : shape) {
+				switch (c) {
+				case 'C': program->code.push_back({ Opcode::ColorEq, next_color++ }); ++depth; break;
+				case 'S': program->code.push_back({ Opcode::SizeEq, next_size++ }); ++depth; break;
+				case 'N': program->code.push_back({ Opcode::NameEq, next_name++ }); ++depth; program->uses_names = true; break;
+				case 'O': program->code.push_back({ Opcode::Opaque, next_opaque++ }); ++depth; break;
+				case '&': program->code.push_back({ Opcode::And, 0 }); --depth; break;
+				case '|': program->code.push_back({ Opcode::Or, 0 }); --depth; break;
+				case '!':
+					if (!program->code.empty() && program->code.back().op == Opcode::Not) program->code.pop_back();
+					else program->code.push_back({ Opcode::Not, 0 });
+					break;
+				}
+				program->max_depth = std::max(program->max_depth, depth);
+			}
+			return program;
+		}
+
+	public:
+		CompiledQuery compile(Specification<Product>& spec) {
+			CompiledQuery query;
+			std::string shape;
+			linearize(spec, shape, query.bindings);
+
+			auto found = cache.find(shape);
+			if (found != cache.end()) {
+				++hits;
+				query.program = found->second;
+			}
+			else {
+				++misses;
+				query.program = build(shape);
+				cache.emplace(std::move(shape), query.program);
+			}
+			return query;
+		}
+
+		size_t cache_hits() const { return hits; }
+		size_t cache_misses() const { return misses; }
+	};
+
+	void main() {
+		std::vector<Product> storage;
+		for (int i = 0; i < 200000; ++i) {
+			storage.push_back(Product{ "Product " + std::to_string(i % 1000), static_cast<Color>(i % 3), static_cast<Size>((i / 7) % 3) });
+		}
+		std::vector<Product*> products;
+		for (auto& p : storage) products.push_back(&p);
+
+		//Simulate user queries of the form (color && size) || !(name), each one a fresh tree of heap objects.
+		std::mt19937 rng{ 42 };
+		SpecCompiler compiler;
+		double tree_ms = 0, compiled_ms = 0;
+		size_t tree_rows = 0, compiled_rows = 0;
+		for (int q = 0; q < 100; ++q) {
+			std::vector<std::unique_ptr<Specification<Product>>> nodes;
+			auto make = [&](auto* node) -> Specification<Product>& { nodes.emplace_back(node); return *node; };
+
+			auto& color = make(new ColorSpec<Product>{ static_cast<Color>(rng() % 3) });
+			auto& size = make(new SizeSpec<Product>{ static_cast<Size>(rng() % 3) });
+			auto& name = make(new NameSpec<Product>{ "Product " + std::to_string(rng() % 1000) });
+			auto& color_and_size = make(new AndSpecification<Product>{ color, size });
+			auto& not_name = make(new NotSpecification<Product>{ name });
+			auto& query = make(new OrSpecification<Product>{ color_and_size, not_name });
+
+			auto start = std::chrono::steady_clock::now();
+			tree_rows += BetterFilter{}.filter(products, query).size();
+			tree_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			compiled_rows += compiler.compile(query).filter(products).size();
+			compiled_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		std::cout << "Specification tree: " << tree_rows << " rows in " << tree_ms << " ms" << std::endl;
+		std::cout << "Compiled program:   " << compiled_rows << " rows in " << compiled_ms << " ms" << std::endl;
+		std::cout << "Compilation cache: " << compiler.cache_hits() << " hits, " << compiler.cache_misses() << " misses" << std::endl;
+	}
+}
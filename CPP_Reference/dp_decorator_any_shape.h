@@ -0,0 +1,244 @@
+#pragma once
+#include <new>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <iostream>
+#include <type_traits>
+#include "dp_decorator_dynamic.h"
+
+//ColorDec and TransDec hold a Shape&, so a decorated shape can't outlive the shapes it decorates and a container of shapes is a container of
+//pointers to separately allocated objects. AnyShape is a shape *value* instead:
+//	- It holds any type with a render(std::string&) const member (Circle, Square, the value decorators below, ...), it doesn't have to
+//	  derive from Shape. The type is erased behind a small table of function pointers (render, copy, move, destroy).
+//	- Small objects are stored inline, in a buffer of Capacity bytes inside the AnyShape (small buffer optimization). Only types that
+//	  don't fit (or could throw while being moved) go to the heap.
+//	- It is copyable and movable, a std::vector<AnyShape> stores the shapes contiguously.
+//Colored<T> and Transparent<T> are the decorators as values: they hold the decorated shape itself instead of a reference.
+//Transparent<Colored<Circle>> is a single object of 32 bytes and fits inline: only stacks composed at compile time can be stored inline.
+//Decorating an AnyShape (Colored<AnyShape>) composes at run-time like the dynamic decorators, but such a chain always goes to the heap:
+//it contains a whole AnyShape (buffer and table pointer), so it is always bigger than the buffer it should fit into.
+
+namespace dp_decorator_any_shape {
+	using dp_decorator_dynamic::Shape;
+	using dp_decorator_dynamic::Circle;
+	using dp_decorator_dynamic::Square;
+	using dp_decorator_dynamic::ColorDec;
+	using dp_decorator_dynamic::TransDec;
+	using dp_decorator_render::append;
+	using Color = ColorDec::Color;
+
+	template <size_t Capacity>
+	class BasicAnyShape {
+		static_assert(Capacity >= sizeof(void*), "The buffer must at least hold a pointer to a heap allocated shape");
+
+		struct VTable {
+			void (*render)(const void* self, std::string& out) noexcept;
+			void (*copy)(const void* from, void* to);
+			void (*move)(void* from, void* to) noexcept;	//Moves into the raw storage at to and destroys from
+			void (*destroy)(void* self) noexcept;
+			bool is_inline;
+		};
+
+		template <typename T>
+		static constexpr bool fits_inline = sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<T>;
+
+		template <typename T>
+		struct InlineModel {
+			static const T& get(const void* self) { return *static_cast<const T*>(self); }
+			static constexpr VTable table{
+				[](const void* self, std::string& out) noexcept { get(self).render(out); },
+				[](const void* from, void* to) { ::new (to) T(get(from)); },
+				[](void* from, void* to) noexcept {
+					::new (to) T(std::move(*static_cast<T*>(from)));
+					static_cast<T*>(from)->~T();
+				},
+				[](void* self) noexcept { static_cast<T*>(self)->~T(); },
+				true
+			};
+		};
+
+		//The buffer only holds the pointer, moving an AnyShape moves the pointer.
+		template <typename T>
+		struct HeapModel {
+			static T* get(const void* self) { return *static_cast<T* const*>(self); }
+			static constexpr VTable table{
+				[](const void* self, std::string& out) noexcept { get(self)->render(out); },
+				[](const void* from, void* to) { ::new (to) T*(new T(*get(from))); },
+				[](void* from, void* to) noexcept { ::new (to) T*(get(from)); },
+				[](void* self) noexcept { delete get(self); },
+				false
+			};
+		};
+
+		alignas(std::max_align_t) unsigned char storage[Capacity];
+		const VTable* vtable{ nullptr };
+
+		void reset() noexcept {
+			if (vtable) vtable->destroy(storage);
+			vtable = nullptr;
+		}
+
+	public:
+		BasicAnyShape() = default;
+
+		template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, BasicAnyShape>>>
+		BasicAnyShape(T&& shape) {
+			using U = std::decay_t<T>;
+			if constexpr (fits_inline<U>) {
+				::new (storage) U(std::forward<T>(shape));
+				vtable = &InlineModel<U>::table;
+			}
+			else {
+				::new (storage) U*(new U(std::forward<T>(shape)));
+				vtable = &HeapModel<U>::table;
+			}
+		}
+
+		BasicAnyShape(const BasicAnyShape& other) {
+			if (other.vtable) other.vtable->copy(other.storage, storage);
+			vtable = other.vtable;
+		}
+
+		//The moved from AnyShape is empty.
+		BasicAnyShape(BasicAnyShape&& other) noexcept {
+			if (other.vtable) other.vtable->move(other.storage, storage);
+			vtable = std::exchange(other.vtable, nullptr);
+		}
+
+		BasicAnyShape& operator=(const BasicAnyShape& other) {
+			if (this != &other) *this = BasicAnyShape{ other };
+			return *this;
+		}
+
+		BasicAnyShape& operator=(BasicAnyShape&& other) noexcept {
+			if (this != &other) {
+				reset();
+				if (other.vtable) other.vtable->move(other.storage, storage);
+				vtable = std::exchange(other.vtable, nullptr);
+			}
+			return *this;
+		}
+
+		~BasicAnyShape() { reset(); }
+
+		void render(std::string& out) const noexcept {
+			if (vtable) vtable->render(storage, out);
+		}
+
+		std::string str() const {
+			std::string out;
+			render(out);
+			return out;
+		}
+
+		bool empty() const noexcept { return vtable == nullptr; }
+		bool is_inline() const noexcept { return vtable && vtable->is_inline; }
+	};
+
+	//48 bytes hold a shape with two levels of value decorators.
+	using AnyShape = BasicAnyShape<48>;
+
+	template <typename T>
+	struct Colored {
+		T shape;
+		Color color;
+
+		void render(std::string& out) const noexcept {
+			shape.render(out);
+			append(out, "and has color ");
+			append(out, templates_enum_reflection::to_string_view(color));
+			out += '\n';
+		}
+	};
+
+	template <typename T>
+	struct Transparent {
+		T shape;
+		float transparancy;
+
+		void render(std::string& out) const noexcept {
+			shape.render(out);
+			append(out, "The transprancy level is ");
+			append(out, transparancy);
+			out += '\n';
+		}
+	};
+
+	void main() {
+		//The decorated shapes no longer depend on locals, they can be returned, copied and stored.
+		auto make_shape = [](int i) -> AnyShape {
+			switch (i % 4) {
+			case 0: return Circle{ 5 };
+			case 1: return Square{ 10 };
+			case 2: return Colored<Circle>{ Circle{ 5 }, Color::Red };
+			default: return Transparent<Colored<Square>>{ Colored<Square>{ Square{ 10 }, Color::Blue }, 111 };
+			}
+		};
+
+		std::vector<AnyShape> shapes;
+		for (int i = 0; i < 4; ++i) shapes.push_back(make_shape(i));
+		AnyShape runtime_chain = Transparent<AnyShape>{ Colored<AnyShape>{ shapes[0], Color::Green }, 12 };	//Too big, on the heap
+		shapes.push_back(runtime_chain);
+
+		std::string buffer;
+		for (const auto& shape : shapes) {
+			buffer.clear();
+			shape.render(buffer);
+			std::cout << buffer << (shape.is_inline() ? "(stored inline)" : "(stored on the heap)") << std::endl;
+		}
+
+		//Building and rendering many shapes: values in one vector against the dynamic decorators, one allocation per object.
+		const int count = 1000000;
+		auto start = std::chrono::steady_clock::now();
+		size_t value_chars = 0;
+		{
+			std::vector<AnyShape> values;
+			values.reserve(count);
+			for (int i = 0; i < count; ++i) values.push_back(make_shape(i));
+			for (const auto& shape : values) {
+				buffer.clear();
+				shape.render(buffer);
+				value_chars += buffer.size();
+			}
+		}
+		auto value_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		size_t pointer_chars = 0;
+		{
+			std::vector<std::unique_ptr<Shape>> owned;	//The decorated shapes, they must stay alive as long as their decorators
+			std::vector<Shape*> pointers;
+			pointers.reserve(count);
+			for (int i = 0; i < count; ++i) {
+				switch (i % 4) {
+				case 0: owned.push_back(std::make_unique<Circle>(5.0f)); break;
+				case 1: owned.push_back(std::make_unique<Square>(10.0f)); break;
+				case 2:
+					owned.push_back(std::make_unique<Circle>(5.0f));
+					owned.push_back(std::make_unique<ColorDec>(*owned.back(), Color::Red));
+					break;
+				default:
+					owned.push_back(std::make_unique<Square>(10.0f));
+					owned.push_back(std::make_unique<ColorDec>(*owned.back(), Color::Blue));
+					owned.push_back(std::make_unique<TransDec>(*owned.back(), 111.0f));
+					break;
+				}
+				pointers.push_back(owned.back().get());
+			}
+			for (const Shape* shape : pointers) {
+				buffer.clear();
+				shape->render(buffer);
+				pointer_chars += buffer.size();
+			}
+		}
+		auto pointer_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "std::vector<AnyShape>:               " << value_ms << " ms (" << value_chars << " characters)" << std::endl;
+		std::cout << "Dynamic decorators, heap allocated:  " << pointer_ms << " ms (" << pointer_chars << " characters)" << std::endl;
+	}
+}
@@ -0,0 +1,298 @@
+#pragma once
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <string_view>
+#include "dp_decorator_function.h"
+#include "templates_enum_reflection.h"
+
+//Every call decorated with the stream based loggers writes two lines to std::cout. std::endl flushes, and the stream is shared by all
+//threads, so the decorated function waits for the terminal (or the file) twice per call.
+//An asynchronous logger moves all of that off the hot path:
+//	- The calling thread only writes a small binary record (timestamp, id of the logger name, start/finish) into a ring buffer that
+//	  belongs to this thread alone. A single producer/single consumer ring needs no lock, just two atomic indices.
+//	- A background thread collects the records of all threads, formats them and writes them in batches.
+//	- If a ring is full the producer either drops the record (and it is counted) or waits for the background thread (Block).
+//AsyncSink plugs this into Logger6 (dp_decorator_function.h): Logger6<F, AsyncSink<>>{ f, "name" }. Only Logger6 has a Sink policy,
+//Logger to Logger5 are the earlier steps of that file and keep writing to std::cout.
+
+namespace dp_decorator_async_log {
+	enum class OverflowPolicy { Drop, Block };
+	constexpr std::array<std::string_view, 2> enum_names(OverflowPolicy) { return { "drop when full", "block when full" }; }
+	std::ostream& operator<<(std::ostream& os, OverflowPolicy policy) {
+		return templates_enum_reflection::write(os, policy);
+	}
+
+	//The names are the messages the backend writes.
+	enum class Event : std::uint8_t { Start, Finish };
+	constexpr std::array<std::string_view, 2> enum_names(Event) { return { "Starting execution ", "Execution finished " }; }
+
+	struct LogRecord {
+		std::uint64_t timestamp_ns;
+		std::uint32_t logger_id;
+		Event event;
+	};
+
+	template <typename T, size_t Capacity>
+	class SpscRing {
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+		alignas(64) std::atomic<size_t> head{ 0 };	//Next slot to read, written by the consumer only
+		alignas(64) std::atomic<size_t> tail{ 0 };	//Next slot to write, written by the producer only
+		alignas(64) T buffer[Capacity];
+
+	public:
+		bool try_push(const T& value) {
+			const size_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+			buffer[t & (Capacity - 1)] = value;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_pop(T& value) {
+			const size_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire)) return false;
+			value = buffer[h & (Capacity - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+	};
+
+	class AsyncLogBackend {
+		static constexpr size_t ring_capacity = 1 << 14;
+		using Ring = SpscRing<LogRecord, ring_capacity>;
+
+		struct ThreadBuffer {
+			Ring ring;
+			std::atomic<std::uint64_t> dropped{ 0 };	//Per thread, so dropping doesn't make the producers fight over one cache line
+			std::atomic<bool> closed{ false };	//The producing thread has exited, remove the buffer once it is drained
+		};
+
+		//Owned by the producing thread, tells the backend when the thread goes away.
+		struct ThreadHandle {
+			std::shared_ptr<ThreadBuffer> buffer;
+			~ThreadHandle() { if (buffer) buffer->closed.store(true, std::memory_order_release); }
+		};
+
+		std::mutex registry;	//Guards names, buffers and out. Producers take it once per thread, never per record.
+		std::mutex writing;		//One drain at a time, held while writing. Taken before registry.
+		std::vector<std::string> names;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		std::ostream* out{ &std::cout };
+
+		const std::chrono::steady_clock::time_point epoch{ std::chrono::steady_clock::now() };
+		std::atomic<std::uint64_t> dropped{ 0 };	//Of the threads that have exited already
+		std::atomic<std::uint64_t> written{ 0 };
+		std::atomic<bool> stopping{ false };
+		std::thread worker;
+
+		ThreadBuffer& local_buffer() {
+			thread_local ThreadHandle handle;
+			if (!handle.buffer) {
+				handle.buffer = std::make_shared<ThreadBuffer>();
+				std::lock_guard<std::mutex> lock{ registry };
+				buffers.push_back(handle.buffer);
+			}
+			return *handle.buffer;
+		}
+
+		static void append_number(std::string& text, std::uint64_t value) {
+			char digits[20];
+			int n = 0;
+			do {
+				digits[n++] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value);
+			while (n) text.push_back(digits[--n]);
+		}
+
+		//Formats everything that is currently in the rings and writes it. Returns the number of records.
+		//The registry is only locked while formatting (names are needed), not during the I/O, so new threads and loggers don't wait
+		//for the output.
+		size_t drain(std::string& batch) {
+			std::lock_guard<std::mutex> drain_lock{ writing };
+			std::unique_lock<std::mutex> lock{ registry };
+			std::ostream* stream = out;
+			size_t count = 0;
+			LogRecord record;
+			for (auto it = buffers.begin(); it != buffers.end();) {
+				auto& buffer = **it;
+				bool closed = buffer.closed.load(std::memory_order_acquire);	//Read before draining, so nothing pushed before closing is lost
+				while (buffer.ring.try_pop(record)) {
+					batch += '[';
+					append_number(batch, record.timestamp_ns / 1000);
+					batch += " us] ";
+					templates_enum_reflection::append(batch, record.event);
+					batch += names[record.logger_id];
+					batch += '\n';
+					++count;
+				}
+				if (closed) {
+					dropped.fetch_add(buffer.dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					it = buffers.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+			lock.unlock();
+			if (!batch.empty()) {
+				stream->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+				stream->flush();
+				batch.clear();
+			}
+			written.fetch_add(count, std::memory_order_relaxed);
+			return count;
+		}
+
+		void run() {
+			std::string batch;
+			while (true) {
+				bool stop = stopping.load(std::memory_order_acquire);
+				size_t count = drain(batch);
+				if (stop && count == 0) break;
+				if (count == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+
+		AsyncLogBackend() : worker{ [this] { run(); } } {}
+
+	public:
+		AsyncLogBackend(const AsyncLogBackend&) = delete;
+		AsyncLogBackend& operator=(const AsyncLogBackend&) = delete;
+
+		~AsyncLogBackend() {
+			stopping.store(true, std::memory_order_release);
+			worker.join();
+		}
+
+		static AsyncLogBackend& instance() {
+			static AsyncLogBackend backend;
+			return backend;
+		}
+
+		std::uint32_t register_name(const std::string& name) {
+			std::lock_guard<std::mutex> lock{ registry };
+			names.push_back(name);
+			return static_cast<std::uint32_t>(names.size() - 1);
+		}
+
+		//Once it returns, nothing is written to the previous stream anymore.
+		void set_output(std::ostream& stream) {
+			std::lock_guard<std::mutex> drain_lock{ writing };
+			std::lock_guard<std::mutex> lock{ registry };
+			out = &stream;
+		}
+
+		void log(std::uint32_t id, Event event, OverflowPolicy policy) {
+			const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch);
+			LogRecord record{ static_cast<std::uint64_t>(elapsed.count()), id, event };
+			auto& buffer = local_buffer();
+			while (!buffer.ring.try_push(record)) {
+				if (policy == OverflowPolicy::Drop) {
+					buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					return;
+				}
+				std::this_thread::yield();
+			}
+		}
+
+		//Waits until everything logged so far has been written.
+		void flush() {
+			std::string batch;
+			while (drain(batch) != 0) {}
+		}
+
+		std::uint64_t dropped_records() {
+			std::lock_guard<std::mutex> lock{ registry };
+			std::uint64_t total = dropped.load(std::memory_order_relaxed);
+			for (const auto& buffer : buffers) total += buffer->dropped.load(std::memory_order_relaxed);
+			return total;
+		}
+		std::uint64_t written_records() const { return written.load(std::memory_order_relaxed); }
+	};
+
+	//The Sink policy for Logger6. The name is registered once when the logger is created, afterwards only the id is logged.
+	template <OverflowPolicy Policy = OverflowPolicy::Drop>
+	struct AsyncSink {
+		using Handle = std::uint32_t;
+		static Handle open(const std::string& name) { return AsyncLogBackend::instance().register_name(name); }
+		static void start(Handle id) { AsyncLogBackend::instance().log(id, Event::Start, Policy); }
+		static void finish(Handle id) { AsyncLogBackend::instance().log(id, Event::Finish, Policy); }
+	};
+
+	//The synchronous baseline: the messages of StreamSink, written to one shared stream under a lock. std::cout is only safe to
+	//share between threads while it writes through stdio, not once its rdbuf() is replaced by a file.
+	struct LockedStreamSink {
+		using Handle = std::string;
+		static inline std::ostream* stream{ &std::cout };
+		static inline std::mutex lock;
+
+		static Handle open(const std::string& name) { return name; }
+		static void start(const Handle& name) {
+			std::lock_guard<std::mutex> guard{ lock };
+			*stream << "Starting execution " << name << '\n';
+		}
+		static void finish(const Handle& name) {
+			std::lock_guard<std::mutex> guard{ lock };
+			*stream << "Execution finished " << name << '\n';
+		}
+	};
+
+	void main() {
+		using dp_decorator_function::Logger6;
+		using dp_decorator_function::add;
+		using dp_decorator_function::add_quiet;
+
+		auto& backend = AsyncLogBackend::instance();
+		Logger6<decltype(&add), AsyncSink<>>{ add, "add (async)" }(1.5, 2.5);
+		backend.flush();
+
+		//Throughput: one thread per spare core calling a decorated function, both sinks log into the same file.
+		//The background thread needs a core of its own, on a single core machine it competes with the callers.
+		auto path = std::filesystem::temp_directory_path() / "dp_decorator_async_log.txt";
+		std::ofstream file{ path };
+		LockedStreamSink::stream = &file;
+		backend.set_output(file);
+
+		const int threads = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()) - 1), calls = 100000;
+		auto measure = [&](const std::string& label, auto make_logger) {
+			auto start = std::chrono::steady_clock::now();
+			std::vector<std::thread> workers;
+			for (int t = 0; t < threads; ++t) {
+				workers.emplace_back([&] {
+					auto logger = make_logger();
+					double sum = 0;
+					for (int i = 0; i < calls; ++i) sum = logger(sum, 1.0);
+				});
+			}
+			for (auto& w : workers) w.join();
+			auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+			backend.flush();
+			std::cerr << std::left << std::setw(31) << label << ns << " ns per call and thread" << std::endl;
+		};
+
+		auto async_label = [](OverflowPolicy policy) { return "AsyncSink, " + std::string{ templates_enum_reflection::to_string_view(policy) } + ":"; };
+		measure("Stream under a lock:", [] { return Logger6<decltype(&add_quiet), LockedStreamSink>{ add_quiet, "add" }; });
+		measure(async_label(OverflowPolicy::Drop), [] { return Logger6<decltype(&add_quiet), AsyncSink<OverflowPolicy::Drop>>{ add_quiet, "add" }; });
+		measure(async_label(OverflowPolicy::Block), [] { return Logger6<decltype(&add_quiet), AsyncSink<OverflowPolicy::Block>>{ add_quiet, "add" }; });
+
+		LockedStreamSink::stream = &std::cout;
+		backend.set_output(std::cout);
+		file.close();
+		std::filesystem::remove(path);
+		std::cout << backend.written_records() << " records written, " << backend.dropped_records() << " dropped" << std::endl;
+	}
+}
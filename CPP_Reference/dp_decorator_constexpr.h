@@ -0,0 +1,207 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include "dp_decorator_render.h"
+
+//The static decorators of db_decorator_static, but constexpr: ColoredShape<TransparentShape<Circle>>{ "Red", 111, 12 } built from
+//constants has a description that is known at compile time, so it can be rendered by the compiler:
+//	constexpr auto text = describe(ColoredShape<TransparentShape<Circle>>{ "Red", 111, 12 });	//FixedString, no code runs at runtime
+//render() is a template over the output: a FixedString<N> (usable in constant expressions) or a std::string, which is the fallback for
+//shapes built from runtime values (str()). Both produce the same text as db_decorator_static, numbers are formatted like std::ostream
+//does by default (%g with 6 significant digits).
+
+namespace dp_decorator_constexpr {
+	using dp_decorator_render::append;
+
+	//A string with a fixed capacity that lives entirely inside the object, hence it can be built in a constant expression.
+	template <size_t N>
+	struct FixedString {
+		char data[N]{};
+		size_t length{ 0 };
+
+		constexpr FixedString& operator+=(char c) {
+			if (length == N) throw std::length_error("FixedString capacity exceeded");
+			data[length++] = c;
+			return *this;
+		}
+
+		constexpr std::string_view view() const { return { data, length }; }
+		constexpr size_t size() const { return length; }
+	};
+
+	template <size_t N>
+	std::ostream& operator<<(std::ostream& os, const FixedString<N>& text) {
+		return os.write(text.data, static_cast<std::streamsize>(text.length));
+	}
+
+	template <size_t N>
+	constexpr void append(FixedString<N>& out, std::string_view text) {
+		for (char c : text) out += c;
+	}
+
+	template <size_t N>
+	constexpr void append(FixedString<N>& out, unsigned value) {
+		char digits[10]{};
+		int count = 0;
+		do {
+			digits[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value);
+		while (count) out += digits[--count];
+	}
+
+	//%g with precision 6, what std::ostream prints for a float by default. std::to_chars isn't constexpr for floating point (yet).
+	template <size_t N>
+	constexpr void append(FixedString<N>& out, float number) {
+		double value = number;
+		if (value != value) { append(out, std::string_view{ "nan" }); return; }
+		if (value < 0) { out += '-'; value = -value; }
+		if (value == 0) { out += '0'; return; }
+		if (value - value != 0) { append(out, std::string_view{ "inf" }); return; }
+
+		//Powers of ten up to 1e22 are exact doubles, so the scaling below rounds once.
+		auto power_of_ten = [](int e) {
+			double p = 1;
+			while (e-- > 0) p *= 10;
+			return p;
+		};
+		int exponent = 0;
+		while (value >= power_of_ten(exponent + 1)) ++exponent;
+		while (value < (exponent >= 0 ? power_of_ten(exponent) : 1 / power_of_ten(-exponent))) --exponent;
+
+		const double scaled = exponent >= 5 ? value / power_of_ten(exponent - 5) : value * power_of_ten(5 - exponent);
+		auto digits = static_cast<std::uint64_t>(scaled);	//6 significant digits, ties to even like printf
+		const double fraction = scaled - static_cast<double>(digits);
+		if (fraction > 0.5 || (fraction == 0.5 && (digits & 1))) ++digits;
+		if (digits >= 1000000) {
+			digits /= 10;
+			++exponent;
+		}
+		char text[6]{};
+		for (int i = 5; i >= 0; --i, digits /= 10) text[i] = static_cast<char>('0' + digits % 10);
+		int significant = 6;
+		while (significant > 1 && text[significant - 1] == '0') --significant;
+
+		if (exponent >= -4 && exponent < 6) {
+			if (exponent < 0) {
+				out += '0';
+				out += '.';
+				for (int i = -1; i > exponent; --i) out += '0';
+				for (int i = 0; i < significant; ++i) out += text[i];
+				return;
+			}
+			for (int i = 0; i <= exponent; ++i) out += text[i];
+			if (significant > exponent + 1) {
+				out += '.';
+				for (int i = exponent + 1; i < significant; ++i) out += text[i];
+			}
+			return;
+		}
+		out += text[0];
+		if (significant > 1) {
+			out += '.';
+			for (int i = 1; i < significant; ++i) out += text[i];
+		}
+		out += 'e';
+		out += exponent < 0 ? '-' : '+';
+		const unsigned magnitude = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+		if (magnitude < 10) out += '0';
+		append(out, magnitude);
+	}
+
+	//No virtual functions: the layers are combined at compile time, exactly like the mixins of db_decorator_static.
+	class Square {
+		float side;
+	public:
+		constexpr Square(float s) : side{ s } {}
+
+		template <typename Out>
+		constexpr void render(Out& out) const {
+			append(out, std::string_view{ "The square side is " });
+			append(out, side);
+			out += '\n';
+		}
+	};
+
+	class Circle {
+		float radius;
+	public:
+		constexpr Circle(float r) : radius{ r } {}
+
+		template <typename Out>
+		constexpr void render(Out& out) const {
+			append(out, std::string_view{ "The circle radius is " });
+			append(out, radius);
+			out += '\n';
+		}
+
+		constexpr void resize(float r) { radius *= r; }
+	};
+
+	template <typename T>
+	class ColoredShape : public T {
+		std::string_view color;	//A literal, or a string that outlives the shape
+	public:
+		template <typename... Args>
+		constexpr ColoredShape(std::string_view color_, Args ...args) : T(args...), color{ color_ } {}
+
+		template <typename Out>
+		constexpr void render(Out& out) const {
+			T::render(out);
+			append(out, std::string_view{ ", the color is " });
+			append(out, color);
+			out += '\n';
+		}
+	};
+
+	template <typename T>
+	class TransparentShape : public T {
+		std::uint8_t transparency;
+	public:
+		template <typename... Args>
+		constexpr TransparentShape(std::uint8_t t, Args ...args) : T(args...), transparency{ t } {}
+
+		template <typename Out>
+		constexpr void render(Out& out) const {
+			T::render(out);
+			append(out, std::string_view{ " has " });
+			append(out, static_cast<unsigned>(transparency));
+			append(out, std::string_view{ " transparency." });
+			out += '\n';
+		}
+	};
+
+	//Compile time (if the shape is a constant) or runtime, without allocating.
+	template <size_t N = 256, typename S>
+	constexpr FixedString<N> describe(const S& shape) {
+		FixedString<N> out;
+		shape.render(out);
+		return out;
+	}
+
+	//The runtime fallback, same text in a std::string.
+	template <typename S>
+	std::string str(const S& shape) {
+		std::string out;
+		shape.render(out);
+		return out;
+	}
+
+	void main() {
+		constexpr auto red_circle = describe(ColoredShape<TransparentShape<Circle>>{ "Red", 111, 12 });
+		static_assert(red_circle.view() == "The circle radius is 12\n has 111 transparency.\n, the color is Red\n");
+		static_assert(describe(Square{ 0.000125f }).view() == "The square side is 0.000125\n");
+		static_assert(describe(Square{ 1234567.0f }).view() == "The square side is 1.23457e+06\n");
+		std::cout << red_circle;
+
+		//Values only known at runtime take the same code path, into a std::string or a FixedString.
+		const float radius = static_cast<float>(std::rand() % 100) / 8;
+		ColoredShape<Circle> runtime_circle{ "Green", radius };
+		std::cout << str(runtime_circle) << describe(runtime_circle);
+	}
+}
@@ -1,6 +1,10 @@
 #pragma once
+#include <array>
 #include <string>
 #include <sstream>
+#include <string_view>
+#include "dp_decorator_render.h"
+#include "templates_enum_reflection.h"
 
 //In addition to the dynamic decorator, the following code also shows how to handle a situation where we need virtual dispatch but
 //we can't make the funciton virtual. Concretely, we have operator<< that we can't make virtual but we would like to behave differently
@@ -10,11 +14,29 @@
 //However, it also hides the implementation of the original class that is decorated, 
 //hence if it offer any additional interface, it is hidden and can no longer be accessed directly.
 //This will be solved through static decorators.
+
+//Every shape renders itself by appending to a buffer (render), a decorator appends its own text after the text of the shape it wraps.
+//Building a std::ostringstream per layer and copying the inner str() into it would cost d streams and O(d^2) copied characters for a
+//chain of depth d, render() writes every character once. str() and printer() are thin wrappers around it.
 namespace dp_decorator_dynamic {
+	using dp_decorator_render::append;
+
 	class Shape {
 	public:
-		virtual std::string str() const noexcept = 0;
-		virtual ostream& printer(ostream& out) = 0;
+		virtual ~Shape() = default;
+		virtual void render(std::string& out) const noexcept = 0;
+
+		std::string str() const noexcept {
+			std::string out;
+			render(out);
+			return out;
+		}
+
+		virtual ostream& printer(ostream& out) {
+			std::string text;
+			render(text);
+			return out << text;
+		}
 	};
 
 	std::ostream& operator<<(std::ostream& out, Shape& s) {
@@ -27,15 +49,10 @@ namespace dp_decorator_dynamic {
 	public:
 		Circle(float r) :radius(r) {}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The radius of the circle is " << radius << std::endl;
-			return oss.str();
-		}
-
-		ostream& printer(ostream& out) override {
-			out << "The radius of the circle is " << radius << std::endl;
-			return out;
+		void render(std::string& out) const noexcept override {
+			append(out, "The radius of the circle is ");
+			append(out, radius);
+			out += '\n';
 		}
 	};
 
@@ -44,15 +61,10 @@ namespace dp_decorator_dynamic {
 	public:
 		Square(float s) :side(s) {}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The length of the square side is " << side << std::endl;
-			return oss.str();
-		}
-
-		ostream& printer(ostream& out) override {
-			out << "The length of the square side is " << side << std::endl;
-			return out;
+		void render(std::string& out) const noexcept override {
+			append(out, "The length of the square side is ");
+			append(out, side);
+			out += '\n';
 		}
 	};
 
@@ -67,34 +79,20 @@ namespace dp_decorator_dynamic {
 			Black,
 			Brown
 		};
+		friend constexpr std::array<std::string_view, 6> enum_names(Color) {
+			return { "Red", "Green", "Blue", "White", "Black", "Brown" };
+		}
 		friend std::ostream& operator<<(std::ostream& os, Color c) {
-			switch (c) {
-			case Color::Red:		os << "Red" << endl;	break;
-			case Color::Green:	os << "Green" << endl;	break;
-			case Color::Blue:		os << "Blue" << endl;	break;
-			case Color::White:	os << "White" << endl;	break;
-			case Color::Black:	os << "Black" << endl;	break;
-			case Color::Brown:	os << "Brown" << endl;	break;
-			}
-			return os;
+			return templates_enum_reflection::write(os, c);
 		}
 	public:
 		ColorDec(Shape& s, enum Color c) : shp(s), shp_color{ c } {}
 //		ColorDec(Shape&& s, enum Color c) : shp(s), shp_color{ c } {}
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			//oss << shp.str()
-			//	<< "and has color " << static_cast<std::underlying_type<Color>::type>(shp_color) << std::endl;
-
-			oss << shp.str()
-				<< "and has color " << shp_color << std::endl;
-			return oss.str();
-		}
-
-		std::ostream& printer(std::ostream& out) {
-			out << shp.str()
-				<< "and has color " << shp_color << std::endl;
-			return out;
+		void render(std::string& out) const noexcept override {
+			shp.render(out);
+			append(out, "and has color ");
+			append(out, templates_enum_reflection::to_string_view(shp_color));
+			out += '\n';
 		}
 
 	private:
@@ -109,17 +107,11 @@ namespace dp_decorator_dynamic {
 		TransDec(Shape& s, float t) : shp{ s }, transparancy(t){}
 //		TransDec(Shape&& s, float t) : shp{ s }, transparancy(t){}
 
-		std::ostream& printer(std::ostream& out) {
-			out << shp
-				<< "The transprancy level is " << transparancy << std::endl;
-			return out;
-		}
-
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << shp
-				<< "The transprancy level is " << transparancy << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			shp.render(out);
+			append(out, "The transprancy level is ");
+			append(out, transparancy);
+			out += '\n';
 		}
 	};
 
@@ -134,6 +126,15 @@ namespace dp_decorator_dynamic {
 		TransDec trans_red_circle{ red_circle, 111 };
 		
 		std::cout << trans_red_circle.str() << std::endl;
+
+		//One buffer for all the shapes, once it is large enough rendering doesn't allocate anymore.
+		const Shape* shapes[] = { &c, &s, &red_circle, &trans_square, &trans_red_circle };
+		std::string buffer;
+		for (const Shape* shape : shapes) {
+			buffer.clear();
+			shape->render(buffer);
+			std::cout << buffer;
+		}
 //		TransDec{ ColorDec{c, ColorDec::Color::Green}, 111 };
 	//	ColorDec
 
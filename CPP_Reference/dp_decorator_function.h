@@ -2,6 +2,16 @@
 #include <functional>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <chrono>
+#include <utility>
+#include <streambuf>
+#include <type_traits>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include "concurrency_thread_pool.h"
 
 namespace dp_decorator_function {
 	/********************** Start *************************/
@@ -132,6 +142,206 @@ namespace dp_decorator_function {
 		}
 	};
 
+	/********************** End *************************/
+	/********************** Start *************************/
+	//Next iteration, the decorator should cost nothing compared to calling the function directly.
+	//Logger3/4/5 pay for std::function: type erasure, possibly a heap allocation for the callable and an indirect call that can't be inlined.
+	//On top of that they take Args ...args by value and call func(args...), so every argument is copied once more.
+	//Logger6 fixes all of it:
+	//	- The callable is stored with its own type F (a function pointer, a lambda, a move-only functor), the compiler sees the real call.
+	//	- operator() takes forwarding references and std::forward()s them, nothing is copied that the callee doesn't copy itself.
+	//	- decltype(auto) returns exactly what the callee returns (values, references, void), if constexpr handles void.
+	//	- Where the messages go is a policy (Sink), and with DP_DECORATOR_LOGGING defined to 0 the logging is compiled out completely.
+	//	  A sink turns the name into a Handle once, in the constructor (StreamSink keeps the name, the async sink an id).
+	//Class template argument deduction works through the deduction guide below, Logger6{ add, "add" } is all it takes.
+
+#ifndef DP_DECORATOR_LOGGING
+#define DP_DECORATOR_LOGGING 1
+#endif
+
+	//Default sink, the same messages as the other loggers. '\n' instead of std::endl, flushing on every call is the sink's business.
+	struct StreamSink {
+		using Handle = std::string;
+		static Handle open(const std::string& name) { return name; }
+		static void start(const Handle& name) { std::cout << "Starting execution " << name << '\n'; }
+		static void finish(const Handle& name) { std::cout << "Execution finished " << name << '\n'; }
+	};
+
+	template <typename F, typename Sink = StreamSink, bool Enabled = (DP_DECORATOR_LOGGING != 0)>
+	class Logger6 {
+		F func;
+		typename Sink::Handle handle;
+
+		template <typename Self, typename... Args>
+		static decltype(auto) call(Self& self, Args&&... args) {
+			if constexpr (!Enabled) {
+				return std::invoke(self.func, std::forward<Args>(args)...);
+			}
+			else if constexpr (std::is_void_v<std::invoke_result_t<decltype((self.func)), Args...>>) {
+				Sink::start(self.handle);
+				std::invoke(self.func, std::forward<Args>(args)...);
+				Sink::finish(self.handle);
+			}
+			else {
+				Sink::start(self.handle);
+				decltype(auto) result = std::invoke(self.func, std::forward<Args>(args)...);
+				Sink::finish(self.handle);
+				if constexpr (std::is_reference_v<decltype(result)>) {
+					return static_cast<decltype(result)>(result);
+				}
+				else {
+					return result;	//NRVO or move
+				}
+			}
+		}
+
+	public:
+		template <typename G>
+		Logger6(G&& f, const std::string& name) : func{ std::forward<G>(f) }, handle{ Sink::open(name) } {}
+
+		template <typename... Args>
+		decltype(auto) operator() (Args&&... args) {
+			return call(*this, std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		decltype(auto) operator() (Args&&... args) const {
+			return call(*this, std::forward<Args>(args)...);
+		}
+	};
+
+	template <typename G>
+	Logger6(G&&, const std::string&) -> Logger6<std::decay_t<G>>;
+
+	//add() prints its result, which would dominate any measurement. This one is just the arithmetic.
+	double add_quiet(double a, double b) {
+		return a + b;
+	}
+
+	//Compares the cost of the decoration itself. Both loggers write into a discarding stream buffer, so only the call overhead differs.
+	void benchmark() {
+		struct NullBuffer : std::streambuf {
+			int overflow(int c) override { return c; }
+		} null_buffer;
+		const int calls = 10000000;
+		auto measure = [calls](const char* label, auto&& f) {
+			double sum = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < calls; ++i) sum = f(sum, 1.0);
+			auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+			std::cerr << label << ns << " ns/call (sum " << sum << ")" << std::endl;
+		};
+
+		auto* old_buffer = std::cout.rdbuf(&null_buffer);
+		measure("Logger5 (std::function, logging):    ", Logger5{ add_quiet, "add" });
+		measure("Logger6 (concrete type, logging):    ", Logger6{ add_quiet, "add" });
+		measure("Logger6 (concrete type, no logging): ", Logger6<decltype(&add_quiet), StreamSink, false>{ add_quiet, "add" });
+		auto add_lambda = [](double a, double b) { return a + b; };
+		measure("Logger6 (lambda, no logging):        ", Logger6<decltype(add_lambda), StreamSink, false>{ add_lambda, "add" });
+		measure("Direct call:                         ", add_quiet);
+		std::cout.rdbuf(old_buffer);
+	}
+
+	/********************** End *************************/
+	/********************** Start *************************/
+	//Logger3/4/5 deduce R and Args... from a function pointer only. signature_t does the same for any callable with a single
+	//operator() (lambdas, functors), decorators that need the signature itself (Memoize, ...) use it in their deduction guides.
+
+	template <typename F> struct signature : signature<decltype(&F::operator())> {};
+	template <typename R, typename... Args> struct signature<R(Args...)> { using type = R(Args...); };
+	template <typename R, typename... Args> struct signature<R(*)(Args...)> { using type = R(Args...); };
+	template <typename C, typename R, typename... Args> struct signature<R(C::*)(Args...)> { using type = R(Args...); };
+	template <typename C, typename R, typename... Args> struct signature<R(C::*)(Args...) const> { using type = R(Args...); };
+
+	template <typename F>
+	using signature_t = typename signature<std::decay_t<F>>::type;
+
+	/********************** End *************************/
+	/********************** Start *************************/
+	//Logger4::operator() calls func(args...) right away, on the caller's thread. Async keeps the call site as it is, but schedules the call
+	//on a thread pool (the shared work stealing pool unless another one is given) and returns a std::future for the result.
+	//	Async async_add{ add_quiet };
+	//	std::future<double> sum = async_add(1.0, 2.0);
+	//	std::vector<double> sums = async_add.batch(calls);	//calls is a std::vector<std::tuple<double, double>>, run in parallel chunks
+	//The arguments are copied into the task (like std::async does) and the tasks share ownership of the callable, so neither has to outlive
+	//the call. The callable is called concurrently from several threads, hence always through a const reference.
+	//Decorators compose, Async{ Logger6{ add, "add" } } logs on the pool threads.
+
+	template <typename F>
+	class Async {
+		std::shared_ptr<const F> func;
+		concurrency_thread_pool::ThreadPool* pool;
+
+	public:
+		template <typename G>
+		explicit Async(G&& f, concurrency_thread_pool::ThreadPool& pool_ = concurrency_thread_pool::ThreadPool::shared())
+			: func{ std::make_shared<const F>(std::forward<G>(f)) }, pool{ &pool_ } {}
+
+		template <typename... Args>
+		auto operator() (Args&&... args) const {
+			return pool->submit([func = func](auto&&... values) -> decltype(auto) {
+				return std::invoke(*func, std::forward<decltype(values)>(values)...);
+			}, std::forward<Args>(args)...);
+		}
+
+		//Calls func with every tuple of arguments, chunk_size calls per task, and returns the results in the order of the calls.
+		//The calling thread helps running the chunks while it waits.
+		template <typename... Args>
+		auto batch(const std::vector<std::tuple<Args...>>& calls, size_t chunk_size = 0) const {
+			using R = std::invoke_result_t<const F&, const Args&...>;
+			if (chunk_size == 0) chunk_size = std::max<size_t>(1, calls.size() / (4 * pool->size()));
+
+			auto run_chunk = [func = func, &calls](size_t begin, size_t end) {
+				if constexpr (std::is_void_v<R>) {
+					for (size_t i = begin; i < end; ++i) std::apply(*func, calls[i]);
+				}
+				else {
+					std::vector<R> results;
+					results.reserve(end - begin);
+					for (size_t i = begin; i < end; ++i) results.push_back(std::apply(*func, calls[i]));
+					return results;
+				}
+			};
+
+			//The chunks refer to calls: every submitted one has to finish before an exception may leave batch().
+			std::exception_ptr error;
+			std::vector<decltype(pool->submit(run_chunk, size_t{}, size_t{}))> chunks;
+			chunks.reserve((calls.size() + chunk_size - 1) / chunk_size);
+			try {
+				for (size_t begin = 0; begin < calls.size(); begin += chunk_size) {
+					chunks.push_back(pool->submit(run_chunk, begin, std::min(begin + chunk_size, calls.size())));
+				}
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+
+			std::conditional_t<std::is_void_v<R>, std::nullptr_t, std::vector<R>> results{};
+			if constexpr (!std::is_void_v<R>) results.reserve(calls.size());
+			for (auto& chunk : chunks) {
+				try {
+					if constexpr (std::is_void_v<R>) {
+						pool->wait(chunk);
+					}
+					else {
+						for (auto& result : pool->wait(chunk)) results.push_back(std::move(result));
+					}
+				}
+				catch (...) {
+					if (!error) error = std::current_exception();
+				}
+			}
+			if (error) std::rethrow_exception(error);
+			if constexpr (!std::is_void_v<R>) return results;
+		}
+	};
+
+	template <typename G>
+	Async(G&&) -> Async<std::decay_t<G>>;
+
+	template <typename G>
+	Async(G&&, concurrency_thread_pool::ThreadPool&) -> Async<std::decay_t<G>>;
+
 	/********************** End *************************/
 
 	void main() {
@@ -164,5 +374,28 @@ namespace dp_decorator_function {
 		std::cout << std::endl << "******************************" << std::endl << std::endl;
 
 		Logger5{ add, "Logger 5 test function " }(7.7, 8.8);
+
+		std::cout << std::endl << "******************************" << std::endl << std::endl;
+
+		Logger6{ add, "Logger 6 test function " }(9.9, 10.10);
+
+		//Move-only callables and void results work as well.
+		Logger6 print_owned{ [p = std::make_unique<int>(42)]() { std::cout << "Owned value " << *p << std::endl; }, "Logger 6 move-only lambda " };
+		print_owned();
+
+		std::cout << std::endl << "******************************" << std::endl << std::endl;
+
+		benchmark();
+
+		std::cout << std::endl << "******************************" << std::endl << std::endl;
+
+		Async async_add{ add_quiet };
+		std::cout << "Async add: " << async_add(1.5, 2.5).get() << std::endl;
+		Async{ Logger6{ add, "Logger 6 on the thread pool " } }(1.0, 2.0).wait();
+
+		std::vector<std::tuple<double, double>> calls;
+		for (int i = 0; i < 100000; ++i) calls.emplace_back(i, 0.5);
+		auto sums = async_add.batch(calls);
+		std::cout << "Batch of " << sums.size() << " calls, last result " << sums.back() << std::endl;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include "dp_decorator_function.h"
+
+//Memoize decorates an expensive pure function like Logger3 decorates add: same signature R(Args...), but a call with arguments seen
+//before returns the stored result instead of calling the function again.
+//	Memoize slow_square{ [](int x) { ... }, 4096 };	//Stores the lambda, its signature int(int) comes from signature_t. 4096 results at most
+//	slow_square(12);	//Calls the function
+//	slow_square(12);	//Served from the cache
+//	- The callable is stored by its own type, like in the other decorators, not behind a std::function.
+//	- The key is the tuple of the (decayed) arguments, hashed by combining std::hash of every element. operator() takes the arguments by
+//	  const reference, copies them once into the key and calls the function with the elements of the key.
+//	- The cache is bounded. When it is full, CLOCK picks the victim: every entry has a "referenced" bit that a hit sets, the clock hand
+//	  sweeps over the entries, clears set bits and evicts the first entry whose bit is clear. That approximates LRU, but a hit only sets
+//	  a bit instead of relinking a list.
+//	- The cache is split into shards by hash, each with its own mutex, so concurrent callers rarely wait for each other.
+//	  The function itself is called outside the lock. Two threads missing the same key at once both compute it, the first result is kept.
+
+namespace dp_decorator_memoize {
+	using dp_decorator_function::signature_t;
+
+	struct CacheStats {
+		std::uint64_t hits{ 0 };
+		std::uint64_t misses{ 0 };
+		std::uint64_t evictions{ 0 };
+		size_t entries{ 0 };
+	};
+
+	template <typename Tuple>
+	struct TupleHash {
+		size_t operator()(const Tuple& key) const {
+			return std::apply([](const auto&... values) {
+				std::uint64_t seed = 0x9e3779b97f4a7c15ull;
+				((seed ^= std::hash<std::decay_t<decltype(values)>>{}(values) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)), ...);
+				const std::uint64_t mixed = seed * 0xff51afd7ed558ccdull;	//The shard is taken from the high bits, keep them with a 32 bit size_t
+				return static_cast<size_t>(mixed >> (64 - 8 * sizeof(size_t)));
+			}, key);
+		}
+	};
+
+	template <typename F, typename Signature = signature_t<F>, size_t Shards = 16>
+	class Memoize;
+
+	template <typename F, typename R, typename... Args, size_t Shards>
+	class Memoize<F, R(Args...), Shards> {
+		static_assert(!std::is_void_v<R>, "A function without result has nothing to memoize");
+		static_assert((Shards & (Shards - 1)) == 0, "Shards must be a power of two");
+		static_assert(((!std::is_lvalue_reference_v<Args> || std::is_const_v<std::remove_reference_t<Args>>) && ...),
+			"A function that changes its arguments can't be memoized");
+
+		using Key = std::tuple<std::decay_t<Args>...>;
+		using Hash = TupleHash<Key>;
+
+		struct Entry {
+			Key key;
+			R value;
+			bool referenced;
+		};
+
+		struct alignas(64) Shard {
+			std::mutex lock;
+			std::unordered_map<Key, size_t, Hash> index;	//Key to position in entries
+			std::vector<Entry> entries;
+			size_t hand{ 0 };
+			CacheStats stats;
+		};
+
+		F func;
+		size_t shard_capacity;
+		std::unique_ptr<Shard[]> shards;
+
+		static constexpr int shard_bits = std::countr_zero(Shards);
+
+		static size_t shard_of(size_t hash) {
+			if constexpr (Shards == 1) return 0;
+			else return hash >> (sizeof(size_t) * 8 - shard_bits);
+		}
+
+		//The shard is locked. Returns the position the new entry may use.
+		size_t evict(Shard& shard) {
+			while (shard.entries[shard.hand].referenced) {
+				shard.entries[shard.hand].referenced = false;
+				shard.hand = (shard.hand + 1) % shard.entries.size();
+			}
+			const size_t victim = shard.hand;
+			shard.hand = (shard.hand + 1) % shard.entries.size();
+			shard.index.erase(shard.entries[victim].key);
+			++shard.stats.evictions;
+			return victim;
+		}
+
+	public:
+		template <typename G>
+		Memoize(G&& f, size_t capacity)
+			: func{ std::forward<G>(f) }, shard_capacity{ std::max<size_t>(1, capacity / Shards) }, shards{ new Shard[Shards] } {}
+
+		R operator() (const Args&... args) {
+			Key key{ args... };
+			Shard& shard = shards[shard_of(Hash{}(key))];
+			{
+				std::lock_guard<std::mutex> guard{ shard.lock };
+				auto found = shard.index.find(key);
+				if (found != shard.index.end()) {
+					++shard.stats.hits;
+					auto& entry = shard.entries[found->second];
+					entry.referenced = true;
+					return entry.value;
+				}
+				++shard.stats.misses;
+			}
+
+			R result = std::apply(func, std::as_const(key));
+
+			std::lock_guard<std::mutex> guard{ shard.lock };
+			if (shard.index.find(key) == shard.index.end()) {
+				if (shard.entries.size() < shard_capacity) {
+					shard.index.emplace(key, shard.entries.size());
+					shard.entries.push_back(Entry{ std::move(key), result, false });
+				}
+				else {
+					const size_t slot = evict(shard);
+					shard.index.emplace(key, slot);
+					shard.entries[slot] = Entry{ std::move(key), result, false };
+				}
+			}
+			return result;
+		}
+
+		CacheStats stats() const {
+			CacheStats total;
+			for (size_t i = 0; i < Shards; ++i) {
+				std::lock_guard<std::mutex> guard{ shards[i].lock };
+				total.hits += shards[i].stats.hits;
+				total.misses += shards[i].stats.misses;
+				total.evictions += shards[i].stats.evictions;
+				total.entries += shards[i].entries.size();
+			}
+			return total;
+		}
+
+		void clear() {
+			for (size_t i = 0; i < Shards; ++i) {
+				std::lock_guard<std::mutex> guard{ shards[i].lock };
+				shards[i].index.clear();
+				shards[i].entries.clear();
+				shards[i].hand = 0;
+			}
+		}
+	};
+
+	template <typename G>
+	Memoize(G&&, size_t) -> Memoize<std::decay_t<G>>;
+
+	template <typename R, typename... Args>
+	auto make_memoized(R(*func)(Args...), size_t capacity) {
+		return Memoize<R(*)(Args...)>{ func, capacity };
+	}
+
+	//Deliberately slow: counts the primes below n by trial division.
+	int count_primes(int n) {
+		int count = 0;
+		for (int i = 2; i < n; ++i) {
+			bool prime = true;
+			for (int d = 2; d * d <= i && prime; ++d) prime = i % d != 0;
+			count += prime;
+		}
+		return count;
+	}
+
+	void main() {
+		auto primes = make_memoized(count_primes, 256);
+		std::cout << "Primes below 10000: " << primes(10000) << ", again from the cache: " << primes(10000) << std::endl;
+
+		Memoize distance{ [](double x, double y, std::string unit) { return std::to_string(std::sqrt(x * x + y * y)) + " " + unit; }, 64 };
+		std::cout << "Distance: " << distance(3.0, 4.0, "m") << ", cached: " << distance(3.0, 4.0, "m") << std::endl;
+
+		//4 threads asking for a skewed mix of 1000 different n, the cache holds 512 of them.
+		auto run = [](const char* label, auto&& f) {
+			auto start = std::chrono::steady_clock::now();
+			std::vector<std::thread> workers;
+			std::atomic<long long> total{ 0 };
+			for (int t = 0; t < 4; ++t) {
+				workers.emplace_back([&, t] {
+					std::uint32_t state = 12345u + t;
+					long long sum = 0;
+					for (int i = 0; i < 5000; ++i) {
+						state = state * 1664525u + 1013904223u;
+						const int n = 1000 + static_cast<int>((state >> 8) % 1000 * ((state >> 4) % 1000) / 1000);	//Small n are more frequent
+						sum += f(n);
+					}
+					total += sum;
+				});
+			}
+			for (auto& w : workers) w.join();
+			auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::cout << label << ms << " ms (checksum " << total << ")" << std::endl;
+		};
+
+		Memoize memoized{ count_primes, 512 };
+		run("Direct calls:   ", count_primes);
+		run("Memoized calls: ", memoized);
+		auto stats = memoized.stats();
+		std::cout << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions, "
+			<< stats.entries << " entries" << std::endl;
+	}
+}
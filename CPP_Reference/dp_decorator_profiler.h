@@ -0,0 +1,265 @@
+#pragma once
+#include <bit>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//The Logger decorators tell that a function ran, the Profiler tells how long it took. It is used exactly like Logger6:
+//	Profiler add_profiled{ add, "add" };		//Class template argument deduction, any callable, any signature
+//	add_profiled(1.0, 2.0);
+//	ProfileRegistry::instance().report(std::cout);	//calls, p50, p99, p99.9 and max per name
+//To be cheap enough to leave on:
+//	- The time stamp is the CPU time stamp counter where there is one (a few ns), otherwise steady_clock. Ticks are converted to ns only
+//	  when reporting.
+//	- Latencies go into an HDR style histogram (log-linear buckets, at most ~3% error) instead of being stored one by one.
+//	- Every thread has its own histogram per name. Only the owning thread writes it, so recording is a relaxed load and store, no lock
+//	  and no shared cache line. The report merges the histograms of all threads.
+
+namespace dp_decorator_profiler {
+	inline std::uint64_t read_clock() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	//Buckets 0..63 hold the values 0..63 exactly. Above that every power of two is split into 32 buckets.
+	class Histogram {
+	public:
+		static constexpr unsigned sub_bucket_bits = 5;
+		static constexpr size_t bucket_count = (64 - sub_bucket_bits - 1) * (1u << sub_bucket_bits) + 2 * (1u << sub_bucket_bits);
+
+		static size_t bucket_of(std::uint64_t value) {
+			const int shift = std::max(0, static_cast<int>(std::bit_width(value)) - static_cast<int>(sub_bucket_bits + 1));
+			return (static_cast<size_t>(shift) << sub_bucket_bits) + static_cast<size_t>(value >> shift);
+		}
+
+		//The middle of the range the bucket stands for.
+		static std::uint64_t value_of(size_t bucket) {
+			const size_t shift = bucket < (2u << sub_bucket_bits) ? 0 : (bucket >> sub_bucket_bits) - 1;
+			const std::uint64_t low = static_cast<std::uint64_t>(bucket - (shift << sub_bucket_bits)) << shift;
+			return low + ((std::uint64_t{ 1 } << shift) >> 1);
+		}
+
+		//Only called by the owning thread, hence a plain read-modify-write of the relaxed atomics is enough.
+		void record(std::uint64_t value) {
+			auto& bucket = counts[bucket_of(value)];
+			bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+		}
+
+		void merge_into(std::vector<std::uint64_t>& totals, std::uint64_t& max_value) const {
+			for (size_t i = 0; i < bucket_count; ++i) totals[i] += counts[i].load(std::memory_order_relaxed);
+			max_value = std::max(max_value, max.load(std::memory_order_relaxed));
+		}
+
+	private:
+		std::atomic<std::uint64_t> counts[bucket_count]{};
+		std::atomic<std::uint64_t> max{ 0 };
+	};
+
+	struct ProfileSummary {
+		std::string name;
+		std::uint64_t calls{ 0 };
+		double p50_ns{ 0 };
+		double p99_ns{ 0 };
+		double p999_ns{ 0 };
+		double max_ns{ 0 };
+	};
+
+	class ProfileRegistry {
+		struct Entry {
+			std::string name;
+			std::vector<std::shared_ptr<Histogram>> histograms;	//One per thread that called it, kept after the thread exits
+		};
+
+		std::mutex registry;	//Taken when a name is registered and the first time a thread records for a name, never per call
+		std::vector<Entry> entries;
+
+		const std::uint64_t start_ticks{ read_clock() };
+		const std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
+
+		ProfileRegistry() = default;
+
+		Histogram& create_local(std::uint32_t id, std::vector<Histogram*>& local) {
+			auto histogram = std::make_shared<Histogram>();
+			{
+				std::lock_guard<std::mutex> lock{ registry };
+				entries[id].histograms.push_back(histogram);
+			}
+			if (local.size() <= id) local.resize(id + 1, nullptr);
+			local[id] = histogram.get();
+			return *histogram;
+		}
+
+		//Ticks of read_clock() per ns, measured against steady_clock since the registry was created.
+		double ns_per_tick() const {
+			auto elapsed = std::chrono::steady_clock::now() - start_time;
+			if (elapsed < std::chrono::milliseconds(10)) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+			}
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+			return ns / static_cast<double>(read_clock() - start_ticks);
+		}
+
+	public:
+		ProfileRegistry(const ProfileRegistry&) = delete;
+		ProfileRegistry& operator=(const ProfileRegistry&) = delete;
+
+		static ProfileRegistry& instance() {
+			static ProfileRegistry profiles;
+			return profiles;
+		}
+
+		std::uint32_t register_name(const std::string& name) {
+			std::lock_guard<std::mutex> lock{ registry };
+			entries.push_back(Entry{ name, {} });
+			return static_cast<std::uint32_t>(entries.size() - 1);
+		}
+
+		void record(std::uint32_t id, std::uint64_t ticks) {
+			thread_local std::vector<Histogram*> local;
+			Histogram* histogram = id < local.size() ? local[id] : nullptr;
+			(histogram ? *histogram : create_local(id, local)).record(ticks);
+		}
+
+		//Profilers with the same name are reported together.
+		std::vector<ProfileSummary> summaries() {
+			const double scale = ns_per_tick();
+			std::lock_guard<std::mutex> lock{ registry };
+
+			std::vector<ProfileSummary> result;
+			std::vector<std::string> names;
+			for (const auto& entry : entries) {
+				if (std::find(names.begin(), names.end(), entry.name) == names.end()) names.push_back(entry.name);
+			}
+			for (const auto& name : names) {
+				std::vector<std::uint64_t> totals(Histogram::bucket_count, 0);
+				std::uint64_t max_ticks = 0;
+				for (const auto& entry : entries) {
+					if (entry.name != name) continue;
+					for (const auto& histogram : entry.histograms) histogram->merge_into(totals, max_ticks);
+				}
+
+				ProfileSummary summary;
+				summary.name = name;
+				for (auto count : totals) summary.calls += count;
+				auto percentile = [&](double fraction) {
+					const auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(summary.calls - 1));
+					std::uint64_t seen = 0;
+					for (size_t i = 0; i < totals.size(); ++i) {
+						seen += totals[i];
+						if (seen > rank) return static_cast<double>(std::min(Histogram::value_of(i), max_ticks)) * scale;
+					}
+					return static_cast<double>(max_ticks) * scale;
+				};
+				if (summary.calls) {
+					summary.p50_ns = percentile(0.5);
+					summary.p99_ns = percentile(0.99);
+					summary.p999_ns = percentile(0.999);
+					summary.max_ns = static_cast<double>(max_ticks) * scale;
+				}
+				result.push_back(summary);
+			}
+			return result;
+		}
+
+		void report(std::ostream& os) {
+			os << std::left << std::setw(24) << "function" << std::right << std::setw(12) << "calls" << std::setw(12) << "p50 ns"
+				<< std::setw(12) << "p99 ns" << std::setw(12) << "p99.9 ns" << std::setw(12) << "max ns" << '\n';
+			os << std::fixed << std::setprecision(0);
+			for (const auto& s : summaries()) {
+				os << std::left << std::setw(24) << s.name << std::right << std::setw(12) << s.calls << std::setw(12) << s.p50_ns
+					<< std::setw(12) << s.p99_ns << std::setw(12) << s.p999_ns << std::setw(12) << s.max_ns << '\n';
+			}
+			os << std::defaultfloat << std::setprecision(6);
+		}
+	};
+
+	template <typename F>
+	class Profiler {
+		F func;
+		std::uint32_t id;
+
+		//Records in the destructor, so void results, references and exceptions need no special cases.
+		struct ScopedTimer {
+			std::uint32_t id;
+			std::uint64_t start{ read_clock() };
+			~ScopedTimer() { ProfileRegistry::instance().record(id, read_clock() - start); }
+		};
+
+		template <typename Self, typename... Args>
+		static decltype(auto) call(Self& self, Args&&... args) {
+			ScopedTimer timer{ self.id };
+			return std::invoke(self.func, std::forward<Args>(args)...);
+		}
+
+	public:
+		template <typename G>
+		Profiler(G&& f, const std::string& name) : func{ std::forward<G>(f) }, id{ ProfileRegistry::instance().register_name(name) } {}
+
+		template <typename... Args>
+		decltype(auto) operator() (Args&&... args) {
+			return call(*this, std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		decltype(auto) operator() (Args&&... args) const {
+			return call(*this, std::forward<Args>(args)...);
+		}
+	};
+
+	template <typename G>
+	Profiler(G&&, const std::string&) -> Profiler<std::decay_t<G>>;
+
+	double add(double a, double b) {
+		return a + b;
+	}
+
+	void main() {
+		//Sorting inputs of random length gives a spread of latencies.
+		Profiler sort_profiled{ [](std::vector<int> values) { std::sort(values.begin(), values.end()); return values.size(); }, "sort" };
+		Profiler add_profiled{ add, "add" };
+
+		std::vector<std::thread> workers;
+		for (int t = 0; t < 4; ++t) {
+			workers.emplace_back([&, t] {
+				std::mt19937 rng(t);
+				std::vector<int> values;
+				for (int i = 0; i < 20000; ++i) {
+					values.resize(1 + rng() % (i % 100 == 0 ? 10000 : 100));
+					for (auto& v : values) v = static_cast<int>(rng());
+					sort_profiled(values);
+				}
+			});
+		}
+		for (auto& w : workers) w.join();
+
+		//The cost of the decoration itself.
+		const int calls = 10000000;
+		double sum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < calls; ++i) sum = add_profiled(sum, 1.0);
+		auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+
+		ProfileRegistry::instance().report(std::cout);
+		std::cout << "Profiled add: " << ns << " ns/call (sum " << sum << ")" << std::endl;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <charconv>
+#include <string_view>
+
+//Helpers for the render(std::string& out) functions of the decorated shapes. They append to the caller's buffer, there is no stream and
+//no temporary string, so a whole decorator chain is rendered in one pass into one buffer that can be reused for the next shape.
+//Numbers are formatted like std::ostream does by default (%g with 6 significant digits).
+
+namespace dp_decorator_render {
+	inline void append(std::string& out, std::string_view text) {
+		out.append(text.data(), text.size());
+	}
+
+	inline void append(std::string& out, float value) {
+		char digits[32];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+		out.append(digits, result.ptr);
+	}
+
+	inline void append(std::string& out, unsigned value) {
+		char digits[16];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		out.append(digits, result.ptr);
+	}
+}
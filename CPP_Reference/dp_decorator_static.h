@@ -8,11 +8,21 @@
 #include <iostream>
 #include <iomanip>
 #include <type_traits>
+#include "dp_decorator_render.h"
 
+//Every mixin layer renders by appending its text to the buffer after T::render(out), there is no stream and no copy of the inner text.
 namespace db_decorator_static {
+	using dp_decorator_render::append;
+
 	class Shape {
 	public:
-		virtual std::string str() const noexcept = 0;
+		virtual void render(std::string& out) const noexcept = 0;
+
+		std::string str() const noexcept {
+			std::string out;
+			render(out);
+			return out;
+		}
 	};
 
 	class Square : public Shape {
@@ -20,10 +30,10 @@ namespace db_decorator_static {
 	public:
 		Square(float s) :side{ s } {}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The square side is " << side << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			append(out, "The square side is ");
+			append(out, side);
+			out += '\n';
 		}
 	};
 
@@ -32,10 +42,10 @@ namespace db_decorator_static {
 	public:
 		Circle(float r) : radius{ r } {}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The circle radius is " << radius << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			append(out, "The circle radius is ");
+			append(out, radius);
+			out += '\n';
 		}
 
 		void resize(float r) { radius *= r; }
@@ -56,10 +66,11 @@ namespace db_decorator_static {
 		ColoredShape(const std::string& color, Args ...args)
 			: T(std::forward<Args>(args)...), color{ color } {}	
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << T::str() << ", the color is " << color << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			T::render(out);
+			append(out, ", the color is ");
+			append(out, color);
+			out += '\n';
 		}
 	};
 
@@ -78,10 +89,12 @@ namespace db_decorator_static {
 		TransparentShape(const uint8_t t, Args ...args)
 			: T(std::forward<Args>(args)...), transparency{ t } {}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << T::str() << " has " << static_cast<unsigned>(transparency) << " transparency." << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			T::render(out);
+			append(out, " has ");
+			append(out, static_cast<unsigned>(transparency));
+			append(out, " transparency.");
+			out += '\n';
 		}
 	};
 
@@ -0,0 +1,182 @@
+#pragma once
+#include <new>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+
+//Arenas (also called regions or bump allocators) hand out memory from a few large blocks by simply moving a pointer forward.
+//Allocation is a pointer increment, objects allocated together are next to each other in memory, and everything is released at once
+//when the arena goes away, instead of one delete per object.
+//https://en.wikipedia.org/wiki/Region-based_memory_management
+//
+//	MonotonicArena	- raw bytes, any type and alignment. Nothing is freed individually.
+//	ObjectArena<T>	- contiguous records of one type, runs the destructors when the arena is destroyed.
+//	StringPool		- interns strings: equal strings are stored once and get the same id / string_view.
+
+namespace ds_arena {
+	class MonotonicArena {
+		std::vector<std::unique_ptr<std::byte[]>> blocks;
+		std::byte* cursor{ nullptr };
+		size_t remaining{ 0 };
+		size_t block_size;
+		size_t reserved{ 0 };
+
+		void grow(size_t min_bytes) {
+			size_t size = std::max(block_size, min_bytes);
+			blocks.emplace_back(new std::byte[size]);
+			cursor = blocks.back().get();
+			remaining = size;
+			reserved += size;
+		}
+
+	public:
+		explicit MonotonicArena(size_t block_size_ = 1 << 20) : block_size{ block_size_ } {}
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+		//The blocks go to the new owner, the moved-from arena is left empty (but usable) and allocates new blocks of its own.
+		MonotonicArena(MonotonicArena&& other) noexcept
+			: blocks{ std::move(other.blocks) }, cursor{ std::exchange(other.cursor, nullptr) }, remaining{ std::exchange(other.remaining, 0) },
+			  block_size{ other.block_size }, reserved{ std::exchange(other.reserved, 0) } {
+			other.blocks.clear();
+		}
+
+		MonotonicArena& operator=(MonotonicArena&& other) noexcept {
+			if (this != &other) {
+				reset();	//Frees the own blocks first
+				blocks = std::move(other.blocks);
+				other.blocks.clear();
+				cursor = std::exchange(other.cursor, nullptr);
+				remaining = std::exchange(other.remaining, 0);
+				block_size = other.block_size;
+				reserved = std::exchange(other.reserved, 0);
+			}
+			return *this;
+		}
+
+		void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+			size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+			if (!cursor || padding + bytes > remaining) {
+				grow(bytes + alignment);
+				padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+			}
+			std::byte* p = cursor + padding;
+			cursor = p + bytes;
+			remaining -= padding + bytes;
+			return p;
+		}
+
+		//Releases every block in O(number of blocks). Objects living in the arena are NOT destroyed.
+		void reset() {
+			blocks.clear();
+			cursor = nullptr;
+			remaining = 0;
+			reserved = 0;
+		}
+
+		size_t bytes_reserved() const { return reserved; }
+		size_t block_count() const { return blocks.size(); }
+	};
+
+	template <typename T>
+	class ObjectArena {
+		struct Block {
+			T* data;
+			size_t used;
+		};
+
+		MonotonicArena memory;
+		std::vector<Block> blocks;
+		size_t records_per_block;
+		size_t count{ 0 };
+
+	public:
+		explicit ObjectArena(size_t records_per_block_ = 4096)
+			: memory{ records_per_block_ * sizeof(T) + alignof(T) }, records_per_block{ records_per_block_ } {}
+		ObjectArena(const ObjectArena&) = delete;
+		ObjectArena& operator=(const ObjectArena&) = delete;
+
+		~ObjectArena() {
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				for (auto& block : blocks) {
+					for (size_t i = 0; i < block.used; ++i) block.data[i].~T();
+				}
+			}
+		}
+
+		//Brace initialization, so that aggregates like Product{ name, color, size } can be emplaced directly.
+		template <typename... Args>
+		T* emplace(Args&&... args) {
+			if (blocks.empty() || blocks.back().used == records_per_block) {
+				blocks.push_back(Block{ static_cast<T*>(memory.allocate(records_per_block * sizeof(T), alignof(T))), 0 });
+			}
+			Block& block = blocks.back();
+			T* p = new (block.data + block.used) T{ std::forward<Args>(args)... };
+			++block.used;
+			++count;
+			return p;
+		}
+
+		size_t size() const { return count; }
+		size_t bytes_reserved() const { return memory.bytes_reserved(); }
+	};
+
+	class StringPool {
+		MonotonicArena characters;
+		std::vector<std::string_view> strings;	//Indexed by id
+		std::vector<std::uint32_t> slots;		//Open addressing hash table of id + 1, 0 == empty. No allocation per string.
+
+		static size_t hash(std::string_view s) {
+			size_t h = 14695981039346656037ull;	//FNV-1a
+			for (unsigned char c : s) {
+				h ^= c;
+				h *= 1099511628211ull;
+			}
+			return h;
+		}
+
+		void rehash(size_t new_size) {
+			slots.assign(new_size, 0);
+			for (std::uint32_t id = 0; id < strings.size(); ++id) {
+				size_t i = hash(strings[id]) & (new_size - 1);
+				while (slots[i]) i = (i + 1) & (new_size - 1);
+				slots[i] = id + 1;
+			}
+		}
+
+	public:
+		using Id = std::uint32_t;
+
+		explicit StringPool(size_t block_size = 1 << 16) : characters{ block_size } {
+			slots.assign(1024, 0);
+		}
+
+		//The returned id (and the string_view returned by view()) stay valid for the lifetime of the pool.
+		Id intern(std::string_view s) {
+			if ((strings.size() + 1) * 2 > slots.size()) rehash(slots.size() * 2);
+
+			size_t i = hash(s) & (slots.size() - 1);
+			while (slots[i]) {
+				if (strings[slots[i] - 1] == s) return slots[i] - 1;
+				i = (i + 1) & (slots.size() - 1);
+			}
+
+			char* p = static_cast<char*>(characters.allocate(s.size(), 1));
+			std::memcpy(p, s.data(), s.size());
+			strings.emplace_back(p, s.size());
+			slots[i] = static_cast<Id>(strings.size());
+			return static_cast<Id>(strings.size() - 1);
+		}
+
+		std::string_view view(Id id) const { return strings[id]; }
+		size_t size() const { return strings.size(); }
+		size_t bytes_reserved() const {
+			return characters.bytes_reserved() + strings.capacity() * sizeof(std::string_view) + slots.capacity() * sizeof(std::uint32_t);
+		}
+	};
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <tuple>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include <variant>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+
+//A std::vector<Shape*> with shapes of mixed types (as in temp_crtp::main) is slow to walk:
+//	- every element is a separate allocation somewhere on the heap, the loop chases pointers,
+//	- every call is virtual, and with the types in random order the branch predictor can't guess the target,
+//	- the code of all the overrides competes for the instruction cache.
+//A poly collection (see boost::poly_collection) keeps one contiguous segment (a std::vector) per concrete type instead.
+//for_each() visits segment by segment: inside a segment the type is known at compile time, so the call is direct and can be inlined,
+//the elements are next to each other, and the same code runs for a whole segment. The price is that the insertion order across types
+//is not preserved, which for "do this for every shape" loops doesn't matter.
+
+namespace ds_poly_collection {
+	template <typename... Ts>
+	class PolyCollection {
+		std::tuple<std::vector<Ts>...> segments;
+
+		template <typename T>
+		static constexpr bool is_member = (std::is_same_v<T, Ts> || ...);
+
+		template <typename Segment, typename F>
+		static void visit_segment(Segment& segment, F& f) {
+			for (auto& element : segment) f(element);
+		}
+
+	public:
+		template <typename T>
+		T& insert(T&& value) {
+			using U = std::decay_t<T>;
+			static_assert(is_member<U>, "The type is not one of the types of this collection");
+			return std::get<std::vector<U>>(segments).emplace_back(std::forward<T>(value));
+		}
+
+		template <typename T, typename... Args>
+		T& emplace(Args&&... args) {
+			static_assert(is_member<T>, "The type is not one of the types of this collection");
+			return std::get<std::vector<T>>(segments).emplace_back(std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		std::vector<T>& segment() { return std::get<std::vector<T>>(segments); }
+
+		template <typename T>
+		const std::vector<T>& segment() const { return std::get<std::vector<T>>(segments); }
+
+		//f is called with the concrete type (T&), one segment after the other.
+		template <typename F>
+		void for_each(F&& f) {
+			std::apply([&f](auto&... segment) { (visit_segment(segment, f), ...); }, segments);
+		}
+
+		template <typename F>
+		void for_each(F&& f) const {
+			std::apply([&f](const auto&... segment) { (visit_segment(segment, f), ...); }, segments);
+		}
+
+		size_t size() const {
+			return std::apply([](const auto&... segment) { return (segment.size() + ... + 0); }, segments);
+		}
+
+		void clear() {
+			std::apply([](auto&... segment) { (segment.clear(), ...); }, segments);
+		}
+	};
+
+	struct Shape {
+		virtual double area() const = 0;
+		virtual ~Shape() = default;
+	};
+
+	//final: when the static type is known, the compiler may call (and inline) area() without the virtual dispatch.
+	struct Circle final : Shape {
+		double radius;
+		explicit Circle(double r) : radius{ r } {}
+		double area() const override { return 3.14159265358979 * radius * radius; }
+	};
+
+	struct Square final : Shape {
+		double side;
+		explicit Square(double s) : side{ s } {}
+		double area() const override { return side * side; }
+	};
+
+	struct Rectangle final : Shape {
+		double width, height;
+		Rectangle(double w, double h) : width{ w }, height{ h } {}
+		double area() const override { return width * height; }
+	};
+
+	struct Triangle final : Shape {
+		double base, height;
+		Triangle(double b, double h) : base{ b }, height{ h } {}
+		double area() const override { return 0.5 * base * height; }
+	};
+
+	void main() {
+		const int count = 2000000;
+		const int rounds = 10;
+
+		std::vector<std::unique_ptr<Shape>> owned;
+		std::vector<Shape*> pointers;
+		std::vector<std::variant<Circle, Square, Rectangle, Triangle>> variants;
+		PolyCollection<Circle, Square, Rectangle, Triangle> poly;
+
+		std::mt19937 rng{ 7 };
+		std::uniform_real_distribution<double> size{ 1.0, 10.0 };
+		for (int i = 0; i < count; ++i) {
+			const double a = size(rng), b = size(rng);
+			switch (rng() % 4) {
+			case 0: owned.push_back(std::make_unique<Circle>(a)); variants.emplace_back(Circle{ a }); poly.emplace<Circle>(a); break;
+			case 1: owned.push_back(std::make_unique<Square>(a)); variants.emplace_back(Square{ a }); poly.emplace<Square>(a); break;
+			case 2: owned.push_back(std::make_unique<Rectangle>(a, b)); variants.emplace_back(Rectangle{ a, b }); poly.emplace<Rectangle>(a, b); break;
+			default: owned.push_back(std::make_unique<Triangle>(a, b)); variants.emplace_back(Triangle{ a, b }); poly.emplace<Triangle>(a, b); break;
+			}
+		}
+		//Shapes created over time end up all over the heap, shuffle the pointers to get that effect.
+		for (auto& shape : owned) pointers.push_back(shape.get());
+		std::shuffle(pointers.begin(), pointers.end(), rng);
+
+		auto measure = [&](const char* label, auto&& body) {
+			double total = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < rounds; ++r) total += body();
+			auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double(count) * rounds);
+			std::cout << label << ns << " ns per shape (total area " << total << ")" << std::endl;
+		};
+
+		measure("std::vector<Shape*>, virtual:   ", [&] {
+			double sum = 0;
+			for (const Shape* shape : pointers) sum += shape->area();
+			return sum;
+		});
+		measure("std::vector<std::variant>:      ", [&] {
+			double sum = 0;
+			for (const auto& shape : variants) sum += std::visit([](const auto& s) { return s.area(); }, shape);
+			return sum;
+		});
+		measure("PolyCollection::for_each:       ", [&] {
+			double sum = 0;
+			poly.for_each([&sum](const auto& s) { sum += s.area(); });
+			return sum;
+		});
+	}
+}
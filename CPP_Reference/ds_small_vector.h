@@ -0,0 +1,316 @@
+#pragma once
+#include <new>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <initializer_list>
+#include "templates_basics.h"
+
+//A std::vector always allocates, even for one element. Many vectors in the project are tiny: the indices per key in
+//contains_duplicate_II, the matches of a filter, ... SmallVector<T, N> stores up to N elements inside the object itself and only
+//moves them to the heap when the N + 1st element arrives (LLVM's SmallVector, boost::container::small_vector).
+//	- The inline buffer is a StaticArray of raw bytes with the alignment of T, left uninitialized: the elements are constructed in it
+//	  one by one as they are added, exactly like std::vector does in its heap buffer.
+//	- The interface is the one of std::vector (iterators are pointers), so it can replace a std::vector without changing the code using it.
+//	- Moving a SmallVector that is on the heap steals the buffer. Moving an inline one moves the elements, there is no buffer to steal.
+//	- Unlike std::vector, moving or swapping invalidates iterators of an inline SmallVector, the elements move with it.
+
+namespace ds_small_vector {
+	template <typename T, size_t N>
+	class SmallVector {
+		static_assert(N > 0, "Use std::vector for no inline elements");
+
+		StaticArray<unsigned char, static_cast<int>(N * sizeof(T)), alignof(T)> inline_storage{ static_array_expr::uninitialized };
+		T* first{ inline_data() };
+		size_t count{ 0 };
+		size_t cap{ N };
+
+		T* inline_data() noexcept { return reinterpret_cast<T*>(inline_storage.data()); }
+		const T* inline_data() const noexcept { return reinterpret_cast<const T*>(inline_storage.data()); }
+
+		//Moves the elements into a buffer of new_cap elements (heap, new_cap > N).
+		void reallocate(size_t new_cap) {
+			T* buffer = static_cast<T*>(::operator new(new_cap * sizeof(T), std::align_val_t{ alignof(T) }));
+			if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+				std::uninitialized_move(first, first + count, buffer);
+			}
+			else {
+				try {
+					std::uninitialized_copy(first, first + count, buffer);	//Strong guarantee, like std::vector
+				}
+				catch (...) {
+					::operator delete(buffer, std::align_val_t{ alignof(T) });
+					throw;
+				}
+			}
+			std::destroy(first, first + count);
+			release();
+			first = buffer;
+			cap = new_cap;
+		}
+
+		void release() noexcept {
+			if (!is_inline()) ::operator delete(first, std::align_val_t{ alignof(T) });
+		}
+
+		void grow_for(size_t required) {
+			if (required > cap) reallocate(std::max(required, cap * 2));
+		}
+
+		//Takes the elements of other, which is left empty.
+		void steal(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if (other.is_inline()) {
+				std::uninitialized_move(other.first, other.first + other.count, inline_data());
+				count = other.count;
+				other.clear();
+			}
+			else {
+				first = std::exchange(other.first, other.inline_data());
+				count = std::exchange(other.count, 0);
+				cap = std::exchange(other.cap, N);
+			}
+		}
+
+	public:
+		using value_type = T;
+		using size_type = size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = T*;
+		using const_iterator = const T*;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		SmallVector() noexcept {}
+		explicit SmallVector(size_t n) { resize(n); }
+		SmallVector(size_t n, const T& value) { assign(n, value); }
+		SmallVector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+		template <typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+		SmallVector(It begin_, It end_) { assign(begin_, end_); }
+
+		SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+		SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { steal(std::move(other)); }
+
+		SmallVector& operator=(const SmallVector& other) {
+			if (this != &other) assign(other.begin(), other.end());
+			return *this;
+		}
+
+		SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if (this != &other) {
+				clear();
+				release();
+				first = inline_data();
+				cap = N;
+				steal(std::move(other));
+			}
+			return *this;
+		}
+
+		SmallVector& operator=(std::initializer_list<T> values) {
+			assign(values.begin(), values.end());
+			return *this;
+		}
+
+		~SmallVector() {
+			clear();
+			release();
+		}
+
+		void assign(size_t n, const T& value) {
+			clear();
+			grow_for(n);
+			std::uninitialized_fill_n(first, n, value);
+			count = n;
+		}
+
+		template <typename It, typename = std::enable_if_t<!std::is_integral_v<It>>>
+		void assign(It begin_, It end_) {
+			clear();
+			if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
+				grow_for(static_cast<size_t>(std::distance(begin_, end_)));
+			}
+			for (; begin_ != end_; ++begin_) emplace_back(*begin_);
+		}
+
+		iterator begin() noexcept { return first; }
+		iterator end() noexcept { return first + count; }
+		const_iterator begin() const noexcept { return first; }
+		const_iterator end() const noexcept { return first + count; }
+		const_iterator cbegin() const noexcept { return first; }
+		const_iterator cend() const noexcept { return first + count; }
+		reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+		reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+
+		size_t size() const noexcept { return count; }
+		size_t capacity() const noexcept { return cap; }
+		bool empty() const noexcept { return count == 0; }
+		//True while the elements are in the inline buffer, no heap memory is used.
+		bool is_inline() const noexcept { return first == inline_data(); }
+		static constexpr size_t inline_capacity() noexcept { return N; }
+
+		T* data() noexcept { return first; }
+		const T* data() const noexcept { return first; }
+		T& operator[](size_t i) { return first[i]; }
+		const T& operator[](size_t i) const { return first[i]; }
+		T& front() { return first[0]; }
+		const T& front() const { return first[0]; }
+		T& back() { return first[count - 1]; }
+		const T& back() const { return first[count - 1]; }
+
+		T& at(size_t i) {
+			if (i >= count) throw std::out_of_range("SmallVector::at");
+			return first[i];
+		}
+
+		const T& at(size_t i) const {
+			if (i >= count) throw std::out_of_range("SmallVector::at");
+			return first[i];
+		}
+
+		void reserve(size_t n) { grow_for(n); }
+
+		//Moves the elements back into the inline buffer if they fit.
+		void shrink_to_fit() {
+			if (is_inline() || count > N) return;
+			T* heap = first;
+			std::uninitialized_move(heap, heap + count, inline_data());
+			std::destroy(heap, heap + count);
+			::operator delete(heap, std::align_val_t{ alignof(T) });
+			first = inline_data();
+			cap = N;
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args) {
+			if (count == cap) {
+				//args may refer to an element of this vector, construct the new element before the old ones are moved
+				T value(std::forward<Args>(args)...);
+				reallocate(cap * 2);
+				return *::new (first + count++) T(std::move(value));
+			}
+			return *::new (first + count++) T(std::forward<Args>(args)...);
+		}
+
+		void push_back(const T& value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(std::move(value)); }
+
+		void pop_back() { first[--count].~T(); }
+
+		void clear() noexcept {
+			std::destroy(first, first + count);
+			count = 0;
+		}
+
+		void resize(size_t n) {
+			if (n < count) {
+				std::destroy(first + n, first + count);
+				count = n;
+				return;
+			}
+			grow_for(n);
+			for (; count < n; ++count) ::new (first + count) T();
+		}
+
+		void resize(size_t n, const T& value) {
+			if (n < count) {
+				std::destroy(first + n, first + count);
+				count = n;
+				return;
+			}
+			if (n > cap) {
+				T copy(value);	//value may be an element of this vector
+				grow_for(n);
+				std::uninitialized_fill(first + count, first + n, copy);
+			}
+			else {
+				std::uninitialized_fill(first + count, first + n, value);
+			}
+			count = n;
+		}
+
+		template <typename... Args>
+		iterator emplace(const_iterator pos, Args&&... args) {
+			const size_t index = static_cast<size_t>(pos - first);
+			emplace_back(std::forward<Args>(args)...);
+			std::rotate(first + index, first + count - 1, first + count);
+			return first + index;
+		}
+
+		iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+		iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+		iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+		iterator erase(const_iterator begin_, const_iterator end_) {
+			T* from = first + (begin_ - first);
+			T* to = first + (end_ - first);
+			if (from != to) {
+				T* new_end = std::move(to, first + count, from);
+				std::destroy(new_end, first + count);
+				count = static_cast<size_t>(new_end - first);
+			}
+			return from;
+		}
+
+		void swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			SmallVector temp{ std::move(other) };
+			other = std::move(*this);
+			*this = std::move(temp);
+		}
+
+		friend bool operator==(const SmallVector& a, const SmallVector& b) {
+			return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+		}
+
+		friend bool operator!=(const SmallVector& a, const SmallVector& b) { return !(a == b); }
+	};
+
+	template <typename T, size_t N>
+	void swap(SmallVector<T, N>& a, SmallVector<T, N>& b) noexcept(noexcept(a.swap(b))) { a.swap(b); }
+
+	void main() {
+		SmallVector<std::string, 2> names{ "first" };
+		names.push_back("second");
+		std::cout << "2 names, inline: " << names.is_inline() << std::endl;
+		names.insert(names.begin(), "zeroth");
+		std::cout << "3 names, inline: " << names.is_inline() << ", capacity " << names.capacity() << std::endl;
+		SmallVector<std::string, 2> moved{ std::move(names) };	//Steals the heap buffer
+		for (const auto& name : moved) std::cout << name << ' ';
+		std::cout << std::endl;
+
+		//One small vector of indices per key, the case of contains_duplicate_II: most keys have 1 or 2 entries.
+		const int keys = 200000;
+		const int rounds = 10;
+		auto measure = [&](const char* label, auto vector_tag) {
+			using Vector = typename decltype(vector_tag)::type;
+			size_t total = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < rounds; ++r) {
+				std::unordered_map<int, Vector> indices;
+				indices.reserve(keys);
+				for (int i = 0; i < 2 * keys; ++i) indices[i % keys + (i % 3 == 0 ? keys : 0)].push_back(i);
+				for (const auto& entry : indices) total += entry.second.size();
+			}
+			auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+			std::cout << label << ms << " ms per map (" << total / rounds << " indices)" << std::endl;
+		};
+		measure("std::unordered_map<int, std::vector<int>>:     ", std::type_identity<std::vector<int>>{});
+		measure("std::unordered_map<int, SmallVector<int, 4>>:  ", std::type_identity<SmallVector<int, 4>>{});
+	}
+}
@@ -0,0 +1,425 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include "templates_minmax.h"
+
+//equal<double> of templates_specialization.h compares two numbers with a fixed absolute tolerance of 0.00001. Comparing whole arrays
+//(the results of a regression check against the expected ones) one pair at a time with it is slow, and a fixed absolute tolerance is
+//wrong for values far from 1. Here:
+//	all_equal(a, b, tolerance)		- same size and every pair equal.
+//	count_equal(a, b, tolerance)	- the number of equal pairs (over the common length).
+//	mismatch(a, b, tolerance)		- the index of the first pair that differs (the common length if there is none), like std::mismatch.
+//									  Call it qualified with a tolerance: for two std::vectors ADL also finds std::mismatch(first1, last1, first2).
+//The tolerance is a Tolerance<Policy, T>, the policy is chosen at compile time and every policy is a specialization:
+//	Absolute	|a - b| < epsilon (Tolerance<Absolute, double>{} is equal<double>).
+//	Relative	a == b or |a - b| <= epsilon * max(|a|, |b|) for finite a and b, for values of any magnitude. An infinity only equals itself.
+//	Ulp			at most max_ulps representable numbers between a and b (units in the last place), -0.0 and +0.0 are equal.
+//	Exact		a == b, the default for integers.
+//NaN is never equal to anything (itself included), under every policy. Absolute counts +inf and +inf as different (inf - inf is NaN),
+//like equal<double>, the other policies don't.
+//For float and double the pairs are compared a SIMD register at a time (SSE2, AVX2 if the CPU has it), mismatch stops at the first
+//register with a difference.
+
+namespace templates_approx_equal {
+	struct Absolute {};
+	struct Relative {};
+	struct Ulp {};
+	struct Exact {};
+
+	template <typename Policy, typename T>
+	struct Tolerance;
+
+	template <typename T>
+	struct Tolerance<Absolute, T> {
+		static_assert(std::is_floating_point_v<T>, "Absolute tolerance is for floating point numbers");
+		T epsilon{ static_cast<T>(0.00001) };
+
+		bool operator()(T a, T b) const { return std::abs(a - b) < epsilon; }
+	};
+
+	template <typename T>
+	struct Tolerance<Relative, T> {
+		static_assert(std::is_floating_point_v<T>, "Relative tolerance is for floating point numbers");
+		T epsilon{ static_cast<T>(0.00001) };
+
+		//epsilon * inf would accept anything against an infinity, so the relative branch is for finite numbers only.
+		bool operator()(T a, T b) const {
+			return a == b || (std::isfinite(a) && std::isfinite(b) && std::abs(a - b) <= epsilon * std::max(std::abs(a), std::abs(b)));
+		}
+	};
+
+	//The bits of a float/double read as an integer grow with the value for positive numbers and shrink for negative ones.
+	//ordered() makes them grow over the whole range, so the difference of two of them is the number of floats in between.
+	template <typename T>
+	using bits_t = std::conditional_t<sizeof(T) == 4, std::int32_t, std::int64_t>;
+
+	template <typename T>
+	bits_t<T> ordered(T value) {
+		const auto bits = std::bit_cast<bits_t<T>>(value);
+		return bits < 0 ? std::numeric_limits<bits_t<T>>::min() - bits : bits;
+	}
+
+	template <typename T>
+	struct Tolerance<Ulp, T> {
+		static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "Ulp tolerance is for float and double");
+		std::uint32_t max_ulps{ 4 };
+
+		//|oa - ob| <= max_ulps as one unsigned compare: oa - ob + max_ulps wraps around below 0. The SIMD kernels do the same.
+		bool operator()(T a, T b) const {
+			using U = std::make_unsigned_t<bits_t<T>>;
+			if (a != a || b != b) return false;
+			const U distance = static_cast<U>(static_cast<U>(ordered(a)) - static_cast<U>(ordered(b)) + max_ulps);
+			return distance <= 2 * static_cast<U>(max_ulps);
+		}
+	};
+
+	template <typename T>
+	struct Tolerance<Exact, T> {
+		bool operator()(const T& a, const T& b) const { return a == b; }
+	};
+
+	//0.00001 absolute for floating point numbers, as equal<double>, exact for everything else.
+	template <typename T>
+	using DefaultTolerance = Tolerance<std::conditional_t<std::is_floating_point_v<T>, Absolute, Exact>, T>;
+
+	namespace detail {
+		template <typename Policy, typename T>
+		size_t mismatch_scalar(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+			for (size_t i = 0; i < n; ++i) {
+				if (!tolerance(a[i], b[i])) return i;
+			}
+			return n;
+		}
+
+		template <typename Policy, typename T>
+		size_t count_scalar(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+			size_t count = 0;
+			for (size_t i = 0; i < n; ++i) count += tolerance(a[i], b[i]);
+			return count;
+		}
+
+#if defined(TEMPLATES_MINMAX_X86)
+		//Lanes<Policy, T> exists (available) only for the combinations with a kernel, the others use the scalar loops.
+		namespace sse2 {
+			template <typename Policy, typename T>
+			struct Lanes {
+				static constexpr bool available = false;
+			};
+
+			template <>
+			struct Lanes<Absolute, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m128 epsilon;
+				explicit Lanes(const Tolerance<Absolute, float>& t) : epsilon{ _mm_set1_ps(t.epsilon) } {}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m128 distance = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+					return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(distance, epsilon)));
+				}
+			};
+
+			template <>
+			struct Lanes<Absolute, double> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 2;
+				__m128d epsilon;
+				explicit Lanes(const Tolerance<Absolute, double>& t) : epsilon{ _mm_set1_pd(t.epsilon) } {}
+
+				unsigned equal_mask(const double* a, const double* b) const {
+					const __m128d distance = _mm_andnot_pd(_mm_set1_pd(-0.0), _mm_sub_pd(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+					return static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(distance, epsilon)));
+				}
+			};
+
+			template <>
+			struct Lanes<Relative, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m128 epsilon;
+				explicit Lanes(const Tolerance<Relative, float>& t) : epsilon{ _mm_set1_ps(t.epsilon) } {}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m128 sign = _mm_set1_ps(-0.0f);
+					const __m128 x = _mm_loadu_ps(a), y = _mm_loadu_ps(b);
+					const __m128 distance = _mm_andnot_ps(sign, _mm_sub_ps(x, y));
+					const __m128 magnitude = _mm_max_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y));
+					const __m128 finite = _mm_cmplt_ps(magnitude, _mm_set1_ps(std::numeric_limits<float>::infinity()));
+					const __m128 close = _mm_and_ps(finite, _mm_cmple_ps(distance, _mm_mul_ps(epsilon, magnitude)));
+					return static_cast<unsigned>(_mm_movemask_ps(_mm_or_ps(_mm_cmpeq_ps(x, y), close)));
+				}
+			};
+
+			template <>
+			struct Lanes<Relative, double> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 2;
+				__m128d epsilon;
+				explicit Lanes(const Tolerance<Relative, double>& t) : epsilon{ _mm_set1_pd(t.epsilon) } {}
+
+				unsigned equal_mask(const double* a, const double* b) const {
+					const __m128d sign = _mm_set1_pd(-0.0);
+					const __m128d x = _mm_loadu_pd(a), y = _mm_loadu_pd(b);
+					const __m128d distance = _mm_andnot_pd(sign, _mm_sub_pd(x, y));
+					const __m128d magnitude = _mm_max_pd(_mm_andnot_pd(sign, x), _mm_andnot_pd(sign, y));
+					const __m128d finite = _mm_cmplt_pd(magnitude, _mm_set1_pd(std::numeric_limits<double>::infinity()));
+					const __m128d close = _mm_and_pd(finite, _mm_cmple_pd(distance, _mm_mul_pd(epsilon, magnitude)));
+					return static_cast<unsigned>(_mm_movemask_pd(_mm_or_pd(_mm_cmpeq_pd(x, y), close)));
+				}
+			};
+
+			//SSE2 has no 64 bit integer compare, Ulp for double takes the scalar loop unless AVX2 is there.
+			template <>
+			struct Lanes<Ulp, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m128i offset;	//max_ulps
+				__m128i limit;	//2 * max_ulps + 1, with the sign bit flipped for the unsigned compare
+				explicit Lanes(const Tolerance<Ulp, float>& t)
+					: offset{ _mm_set1_epi32(static_cast<int>(t.max_ulps)) }, limit{ _mm_set1_epi32(static_cast<int>((2 * t.max_ulps + 1) ^ 0x80000000u)) } {}
+
+				static __m128i ordered(__m128 value) {
+					const __m128i bits = _mm_castps_si128(value);
+					const __m128i negative = _mm_srai_epi32(bits, 31);
+					const __m128i flipped = _mm_sub_epi32(_mm_set1_epi32(std::numeric_limits<std::int32_t>::min()), bits);
+					return _mm_or_si128(_mm_and_si128(negative, flipped), _mm_andnot_si128(negative, bits));
+				}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m128 x = _mm_loadu_ps(a), y = _mm_loadu_ps(b);
+					const __m128i distance = _mm_add_epi32(_mm_sub_epi32(ordered(x), ordered(y)), offset);
+					const __m128i close = _mm_cmplt_epi32(_mm_xor_si128(distance, _mm_set1_epi32(std::numeric_limits<std::int32_t>::min())), limit);
+					return static_cast<unsigned>(_mm_movemask_ps(_mm_and_ps(_mm_castsi128_ps(close), _mm_cmpord_ps(x, y))));
+				}
+			};
+
+#include "templates_approx_equal_kernels.inl"
+		}
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+		namespace avx2 {
+			template <typename Policy, typename T>
+			struct Lanes {
+				static constexpr bool available = false;
+			};
+
+			template <>
+			struct Lanes<Absolute, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 8;
+				__m256 epsilon;
+				explicit Lanes(const Tolerance<Absolute, float>& t) : epsilon{ _mm256_set1_ps(t.epsilon) } {}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m256 distance = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), _mm256_sub_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b)));
+					return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(distance, epsilon, _CMP_LT_OQ)));
+				}
+			};
+
+			template <>
+			struct Lanes<Absolute, double> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m256d epsilon;
+				explicit Lanes(const Tolerance<Absolute, double>& t) : epsilon{ _mm256_set1_pd(t.epsilon) } {}
+
+				unsigned equal_mask(const double* a, const double* b) const {
+					const __m256d distance = _mm256_andnot_pd(_mm256_set1_pd(-0.0), _mm256_sub_pd(_mm256_loadu_pd(a), _mm256_loadu_pd(b)));
+					return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(distance, epsilon, _CMP_LT_OQ)));
+				}
+			};
+
+			template <>
+			struct Lanes<Relative, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 8;
+				__m256 epsilon;
+				explicit Lanes(const Tolerance<Relative, float>& t) : epsilon{ _mm256_set1_ps(t.epsilon) } {}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m256 sign = _mm256_set1_ps(-0.0f);
+					const __m256 x = _mm256_loadu_ps(a), y = _mm256_loadu_ps(b);
+					const __m256 distance = _mm256_andnot_ps(sign, _mm256_sub_ps(x, y));
+					const __m256 magnitude = _mm256_max_ps(_mm256_andnot_ps(sign, x), _mm256_andnot_ps(sign, y));
+					const __m256 finite = _mm256_cmp_ps(magnitude, _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_LT_OQ);
+					const __m256 close = _mm256_and_ps(finite, _mm256_cmp_ps(distance, _mm256_mul_ps(epsilon, magnitude), _CMP_LE_OQ));
+					return static_cast<unsigned>(_mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ), close)));
+				}
+			};
+
+			template <>
+			struct Lanes<Relative, double> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m256d epsilon;
+				explicit Lanes(const Tolerance<Relative, double>& t) : epsilon{ _mm256_set1_pd(t.epsilon) } {}
+
+				unsigned equal_mask(const double* a, const double* b) const {
+					const __m256d sign = _mm256_set1_pd(-0.0);
+					const __m256d x = _mm256_loadu_pd(a), y = _mm256_loadu_pd(b);
+					const __m256d distance = _mm256_andnot_pd(sign, _mm256_sub_pd(x, y));
+					const __m256d magnitude = _mm256_max_pd(_mm256_andnot_pd(sign, x), _mm256_andnot_pd(sign, y));
+					const __m256d finite = _mm256_cmp_pd(magnitude, _mm256_set1_pd(std::numeric_limits<double>::infinity()), _CMP_LT_OQ);
+					const __m256d close = _mm256_and_pd(finite, _mm256_cmp_pd(distance, _mm256_mul_pd(epsilon, magnitude), _CMP_LE_OQ));
+					return static_cast<unsigned>(_mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ), close)));
+				}
+			};
+
+			template <>
+			struct Lanes<Ulp, float> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 8;
+				__m256i offset;
+				__m256i limit;
+				explicit Lanes(const Tolerance<Ulp, float>& t)
+					: offset{ _mm256_set1_epi32(static_cast<int>(t.max_ulps)) }, limit{ _mm256_set1_epi32(static_cast<int>((2 * t.max_ulps + 1) ^ 0x80000000u)) } {}
+
+				static __m256i ordered(__m256 value) {
+					const __m256i bits = _mm256_castps_si256(value);
+					const __m256i flipped = _mm256_sub_epi32(_mm256_set1_epi32(std::numeric_limits<std::int32_t>::min()), bits);
+					return _mm256_blendv_epi8(bits, flipped, _mm256_srai_epi32(bits, 31));
+				}
+
+				unsigned equal_mask(const float* a, const float* b) const {
+					const __m256 x = _mm256_loadu_ps(a), y = _mm256_loadu_ps(b);
+					const __m256i distance = _mm256_add_epi32(_mm256_sub_epi32(ordered(x), ordered(y)), offset);
+					const __m256i close = _mm256_cmpgt_epi32(limit, _mm256_xor_si256(distance, _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min())));
+					return static_cast<unsigned>(_mm256_movemask_ps(_mm256_and_ps(_mm256_castsi256_ps(close), _mm256_cmp_ps(x, y, _CMP_ORD_Q))));
+				}
+			};
+
+			template <>
+			struct Lanes<Ulp, double> {
+				static constexpr bool available = true;
+				static constexpr size_t width = 4;
+				__m256i offset;
+				__m256i limit;
+				explicit Lanes(const Tolerance<Ulp, double>& t)
+					: offset{ _mm256_set1_epi64x(static_cast<long long>(t.max_ulps)) },
+					limit{ _mm256_set1_epi64x(static_cast<long long>((2 * std::uint64_t{ t.max_ulps } + 1) ^ 0x8000000000000000ull)) } {}
+
+				static __m256i ordered(__m256d value) {
+					const __m256i bits = _mm256_castpd_si256(value);
+					const __m256i flipped = _mm256_sub_epi64(_mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min()), bits);
+					return _mm256_blendv_epi8(bits, flipped, _mm256_cmpgt_epi64(_mm256_setzero_si256(), bits));
+				}
+
+				unsigned equal_mask(const double* a, const double* b) const {
+					const __m256d x = _mm256_loadu_pd(a), y = _mm256_loadu_pd(b);
+					const __m256i distance = _mm256_add_epi64(_mm256_sub_epi64(ordered(x), ordered(y)), offset);
+					const __m256i close = _mm256_cmpgt_epi64(limit, _mm256_xor_si256(distance, _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min())));
+					return static_cast<unsigned>(_mm256_movemask_pd(_mm256_and_pd(_mm256_castsi256_pd(close), _mm256_cmp_pd(x, y, _CMP_ORD_Q))));
+				}
+			};
+
+#include "templates_approx_equal_kernels.inl"
+		}
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+		template <typename Policy, typename T>
+		size_t mismatch(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+#if defined(TEMPLATES_MINMAX_X86)
+			if constexpr (avx2::Lanes<Policy, T>::available) {
+				if (templates_minmax::detail::has_avx2) return avx2::mismatch_kernel(a, b, n, tolerance);
+			}
+			if constexpr (sse2::Lanes<Policy, T>::available) return sse2::mismatch_kernel(a, b, n, tolerance);
+#endif
+			return mismatch_scalar(a, b, n, tolerance);
+		}
+
+		template <typename Policy, typename T>
+		size_t count(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+#if defined(TEMPLATES_MINMAX_X86)
+			if constexpr (avx2::Lanes<Policy, T>::available) {
+				if (templates_minmax::detail::has_avx2) return avx2::count_kernel(a, b, n, tolerance);
+			}
+			if constexpr (sse2::Lanes<Policy, T>::available) return sse2::count_kernel(a, b, n, tolerance);
+#endif
+			return count_scalar(a, b, n, tolerance);
+		}
+	}
+
+	template <typename R>
+	using element_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::data(std::declval<R&>()))>>;
+
+	template <typename R1, typename R2>
+	using require_same_elements = std::enable_if_t<std::is_same_v<element_t<R1>, element_t<R2>>>;
+
+	template <typename R1, typename R2, typename Tol = DefaultTolerance<element_t<R1>>, typename = require_same_elements<R1, R2>>
+	size_t mismatch(const R1& a, const R2& b, const Tol& tolerance = {}) {
+		return detail::mismatch(std::data(a), std::data(b), std::min(std::size(a), std::size(b)), tolerance);
+	}
+
+	template <typename R1, typename R2, typename Tol = DefaultTolerance<element_t<R1>>, typename = require_same_elements<R1, R2>>
+	size_t count_equal(const R1& a, const R2& b, const Tol& tolerance = {}) {
+		return detail::count(std::data(a), std::data(b), std::min(std::size(a), std::size(b)), tolerance);
+	}
+
+	template <typename R1, typename R2, typename Tol = DefaultTolerance<element_t<R1>>, typename = require_same_elements<R1, R2>>
+	bool all_equal(const R1& a, const R2& b, const Tol& tolerance = {}) {
+		return std::size(a) == std::size(b) && templates_approx_equal::mismatch(a, b, tolerance) == std::size(a);
+	}
+
+	void main() {
+		//A regression check: the results of a new version against the stored ones, equal up to rounding, with one real difference.
+		const size_t count = size_t{ 1 } << 23;
+		std::vector<double> expected(count), actual(count);
+		std::mt19937_64 rng{ 11 };
+		std::uniform_real_distribution<double> value{ -1000.0, 1000.0 };
+		for (size_t i = 0; i < count; ++i) {
+			expected[i] = value(rng);
+			actual[i] = std::nextafter(expected[i], 0.0);	//One ulp off
+		}
+		actual[count - 100] += 0.5;
+
+		auto measure = [&](const char* label, auto&& body) {
+			const int rounds = 5;
+			size_t result = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < rounds; ++r) result = body();
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+			std::cout << label << ms << " ms (" << result << ")" << std::endl;
+		};
+		measure("Scalar loop with |a - b| < 0.00001, mismatch:  ", [&] {
+			size_t i = 0;
+			while (i < count && std::abs(expected[i] - actual[i]) < 0.00001) ++i;
+			return i;
+		});
+		measure("mismatch, Absolute:                            ", [&] { return mismatch(expected, actual); });
+		measure("mismatch, Relative 1e-12:                      ", [&] { return templates_approx_equal::mismatch(expected, actual, Tolerance<Relative, double>{ 1e-12 }); });
+		measure("mismatch, 4 ulps:                              ", [&] { return templates_approx_equal::mismatch(expected, actual, Tolerance<Ulp, double>{ 4 }); });
+		measure("count_equal, 4 ulps:                           ", [&] { return count_equal(expected, actual, Tolerance<Ulp, double>{ 4 }); });
+		measure("mismatch, Exact:                               ", [&] { return templates_approx_equal::mismatch(expected, actual, Tolerance<Exact, double>{}); });
+
+		std::cout << "all_equal, Absolute: " << all_equal(expected, actual) << std::endl;
+		const float small[] = { 1e-7f, 0.0f, -0.0f, std::numeric_limits<float>::quiet_NaN() };
+		const float other[] = { 2e-7f, -0.0f, 0.0f, std::numeric_limits<float>::quiet_NaN() };
+		std::cout << "1e-7 against 2e-7: Absolute " << count_equal(small, other) << " equal, Relative " << count_equal(small, other, Tolerance<Relative, float>{})
+			<< " equal (the NaNs are never equal)" << std::endl;
+		const double inf = std::numeric_limits<double>::infinity();
+		const double blown_up[] = { inf, inf, inf, inf, -inf }, reference[] = { 1.0, 2.0, -inf, 4.0, -inf };
+		std::cout << "Infinities, Relative: " << count_equal(blown_up, reference, Tolerance<Relative, double>{}) << " of 5 equal (only -inf == -inf)" << std::endl;
+		const int ids[] = { 1, 2, 3 }, other_ids[] = { 1, 2, 4 };
+		std::cout << "int, Exact by default: first difference at " << mismatch(ids, other_ids) << std::endl;
+	}
+}
@@ -0,0 +1,32 @@
+//The loops of templates_approx_equal.h, written once against Lanes<Policy, T>, which compares one SIMD register of elements:
+//	width, a constructor from the Tolerance, equal_mask(a, b) - bit i is set if a[i] and b[i] are equal under the tolerance.
+//Included inside every namespace that defines such Lanes (sse2, avx2), so each instruction set gets its own copy compiled for its
+//target. Only include it from templates_approx_equal.h.
+
+	//Index of the first pair that is not equal, n if there is none. Stops at the first register with a difference.
+	template <typename Policy, typename T>
+	size_t mismatch_kernel(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+		using L = Lanes<Policy, T>;
+		constexpr unsigned all = (1u << L::width) - 1;
+		const L lanes{ tolerance };
+		size_t i = 0;
+		for (; i + L::width <= n; i += L::width) {
+			const unsigned equal = lanes.equal_mask(a + i, b + i);
+			if (equal != all) return i + static_cast<size_t>(std::countr_one(equal));
+		}
+		for (; i < n; ++i) {
+			if (!tolerance(a[i], b[i])) return i;
+		}
+		return n;
+	}
+
+	template <typename Policy, typename T>
+	size_t count_kernel(const T* a, const T* b, size_t n, const Tolerance<Policy, T>& tolerance) {
+		using L = Lanes<Policy, T>;
+		const L lanes{ tolerance };
+		size_t count = 0;
+		size_t i = 0;
+		for (; i + L::width <= n; i += L::width) count += static_cast<size_t>(std::popcount(lanes.equal_mask(a + i, b + i)));
+		for (; i < n; ++i) count += tolerance(a[i], b[i]);
+		return count;
+	}
@@ -1,6 +1,13 @@
 #pragma once
-#include <iostream>
+#include <chrono>
+#include <memory>
 #include <string>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+#include <valarray>
+#include <type_traits>
+#include <initializer_list>
 using namespace std;
 
 //*******************************************************************************************************************************************************
@@ -36,24 +43,248 @@ void runnerSize() {
 //****************************************************** Template non-type parameters ************************************************
 //A template non-type parameter is a template parameter where the type of the parameter is predefined and is substituted for a constexpr value passed in as an argument.
 
-template <typename T, int size> // size is an integral non-type parameter
-class StaticArray
+//StaticArray is also a small fixed size numeric array:
+//	- The storage is aligned to 64 bytes by default, a cache line and the width of the widest SIMD registers (AVX-512), so a loop over the
+//	  elements never splits a vector load.
+//	- The arithmetic uses expression templates. a + b * c doesn't compute anything, it returns a small object
+//	  BinaryExpr<StaticArray, BinaryExpr<StaticArray, StaticArray, Mul>, Add> that refers to its operands. Only assigning it to a
+//	  StaticArray (or reducing it with sum/min/max/dot/all/any) runs a loop: one loop over all the operands, no temporary arrays, and
+//	  as the size is a constant and the element function is inlined the compiler vectorizes it.
+//	- The reductions keep one accumulator per SIMD lane, so the steps of different lanes don't depend on each other and the loop
+//	  vectorizes without -ffast-math. For floating point this changes the order of the additions, sum() can differ in the last bits
+//	  from a left to right loop.
+namespace static_array_expr {
+	inline constexpr size_t simd_alignment = 64;
+
+	//Tag for a StaticArray whose elements are left uninitialized (for trivial types), e.g. when it is raw storage that is filled later.
+	struct Uninitialized {};
+	inline constexpr Uninitialized uninitialized{};
+
+	//Base of every expression (CRTP), the operators below only accept expressions.
+	template <typename E>
+	struct ArrayExpr {
+		const E& self() const { return static_cast<const E&>(*this); }
+	};
+
+	//An expression holds the arrays by reference and the nested expressions (which are temporaries) by value.
+	template <typename E>
+	using Operand = std::conditional_t<E::is_terminal, const E&, E>;
+
+	//A scalar operand, the same value for every index. length 0 matches any array length.
+	template <typename T>
+	struct Scalar : ArrayExpr<Scalar<T>> {
+		using value_type = T;
+		static constexpr int length = 0;
+		static constexpr bool is_terminal = false;
+		T value;
+
+		explicit Scalar(T v) : value{ v } {}
+		T operator[](int) const { return value; }
+	};
+
+	template <typename L, typename R, typename Op>
+	struct BinaryExpr : ArrayExpr<BinaryExpr<L, R, Op>> {
+		static_assert(L::length == 0 || R::length == 0 || L::length == R::length, "The arrays must have the same length");
+		using value_type = decltype(Op::apply(std::declval<typename L::value_type>(), std::declval<typename R::value_type>()));
+		static constexpr int length = L::length != 0 ? L::length : R::length;
+		static constexpr bool is_terminal = false;
+		Operand<L> left;
+		Operand<R> right;
+
+		BinaryExpr(const L& l, const R& r) : left(l), right(r) {}
+		value_type operator[](int i) const { return Op::apply(left[i], right[i]); }
+	};
+
+	template <typename A, typename B, typename C>
+	struct MulAddExpr : ArrayExpr<MulAddExpr<A, B, C>> {
+		using value_type = decltype(std::declval<typename A::value_type>() * std::declval<typename B::value_type>() + std::declval<typename C::value_type>());
+		static constexpr int length = A::length;
+		static_assert(A::length == B::length && A::length == C::length, "The arrays must have the same length");
+		static constexpr bool is_terminal = false;
+		Operand<A> a;
+		Operand<B> b;
+		Operand<C> c;
+
+		MulAddExpr(const A& a_, const B& b_, const C& c_) : a(a_), b(b_), c(c_) {}
+		value_type operator[](int i) const { return a[i] * b[i] + c[i]; }
+	};
+
+	template <typename E>
+	struct NegateExpr : ArrayExpr<NegateExpr<E>> {
+		using value_type = decltype(-std::declval<typename E::value_type>());
+		static constexpr int length = E::length;
+		static constexpr bool is_terminal = false;
+		Operand<E> operand;
+
+		explicit NegateExpr(const E& e) : operand(e) {}
+		value_type operator[](int i) const { return -operand[i]; }
+	};
+
+	struct Add { template <typename A, typename B> static auto apply(A a, B b) { return a + b; } };
+	struct Sub { template <typename A, typename B> static auto apply(A a, B b) { return a - b; } };
+	struct Mul { template <typename A, typename B> static auto apply(A a, B b) { return a * b; } };
+	struct Div { template <typename A, typename B> static auto apply(A a, B b) { return a / b; } };
+	struct Less { template <typename A, typename B> static bool apply(A a, B b) { return a < b; } };
+	struct LessEqual { template <typename A, typename B> static bool apply(A a, B b) { return a <= b; } };
+	struct Greater { template <typename A, typename B> static bool apply(A a, B b) { return a > b; } };
+	struct GreaterEqual { template <typename A, typename B> static bool apply(A a, B b) { return a >= b; } };
+	struct Equal { template <typename A, typename B> static bool apply(A a, B b) { return a == b; } };
+	struct NotEqual { template <typename A, typename B> static bool apply(A a, B b) { return a != b; } };
+	//Written as a select so that it maps to the min/max instructions (if an operand is a NaN, the first one is returned).
+	struct Min { template <typename A> static A apply(A a, A b) { return b < a ? b : a; } };
+	struct Max { template <typename A> static A apply(A a, A b) { return a < b ? b : a; } };
+	struct And { static bool apply(bool a, bool b) { return a && b; } };
+	struct Or { static bool apply(bool a, bool b) { return a || b; } };
+
+	//Every operator comes in three forms: expression op expression, expression op scalar and scalar op expression.
+#define STATIC_ARRAY_BINARY_OPERATOR(op, Op)																					\
+	template <typename L, typename R>																						\
+	BinaryExpr<L, R, Op> operator op(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return { l.self(), r.self() }; }		\
+	template <typename L>																									\
+	BinaryExpr<L, Scalar<typename L::value_type>, Op> operator op(const ArrayExpr<L>& l, typename L::value_type r) {		\
+		return { l.self(), Scalar<typename L::value_type>{ r } };																\
+	}																														\
+	template <typename R>																									\
+	BinaryExpr<Scalar<typename R::value_type>, R, Op> operator op(typename R::value_type l, const ArrayExpr<R>& r) {		\
+		return { Scalar<typename R::value_type>{ l }, r.self() };																\
+	}
+
+	STATIC_ARRAY_BINARY_OPERATOR(+, Add)
+	STATIC_ARRAY_BINARY_OPERATOR(-, Sub)
+	STATIC_ARRAY_BINARY_OPERATOR(*, Mul)
+	STATIC_ARRAY_BINARY_OPERATOR(/, Div)
+	STATIC_ARRAY_BINARY_OPERATOR(<, Less)
+	STATIC_ARRAY_BINARY_OPERATOR(<=, LessEqual)
+	STATIC_ARRAY_BINARY_OPERATOR(>, Greater)
+	STATIC_ARRAY_BINARY_OPERATOR(>=, GreaterEqual)
+	STATIC_ARRAY_BINARY_OPERATOR(==, Equal)
+	STATIC_ARRAY_BINARY_OPERATOR(!=, NotEqual)
+#undef STATIC_ARRAY_BINARY_OPERATOR
+
+	template <typename E>
+	NegateExpr<E> operator-(const ArrayExpr<E>& e) { return NegateExpr<E>{ e.self() }; }
+
+	//a * b + c in one pass. The compiler may contract it into FMA instructions where the target has them.
+	template <typename A, typename B, typename C>
+	MulAddExpr<A, B, C> muladd(const ArrayExpr<A>& a, const ArrayExpr<B>& b, const ArrayExpr<C>& c) {
+		return { a.self(), b.self(), c.self() };
+	}
+
+	template <typename Op, typename E>
+	typename E::value_type reduce(const E& e, typename E::value_type identity) {
+		using T = typename E::value_type;
+		constexpr int lanes = static_cast<int>(simd_alignment / sizeof(T));
+		constexpr int n = E::length;
+		T acc[lanes];
+		for (auto& a : acc) a = identity;
+		int i = 0;
+		for (; i + lanes <= n; i += lanes) {
+			for (int l = 0; l < lanes; ++l) acc[l] = Op::apply(acc[l], e[i + l]);
+		}
+		for (; i < n; ++i) acc[0] = Op::apply(acc[0], e[i]);
+		T result = acc[0];
+		for (int l = 1; l < lanes; ++l) result = Op::apply(result, acc[l]);
+		return result;
+	}
+
+	template <typename E>
+	typename E::value_type sum(const ArrayExpr<E>& e) { return reduce<Add>(e.self(), typename E::value_type{}); }
+
+	template <typename E>
+	typename E::value_type min(const ArrayExpr<E>& e) {
+		static_assert(E::length > 0, "min of an empty array");
+		return reduce<Min>(e.self(), e.self()[0]);
+	}
+
+	template <typename E>
+	typename E::value_type max(const ArrayExpr<E>& e) {
+		static_assert(E::length > 0, "max of an empty array");
+		return reduce<Max>(e.self(), e.self()[0]);
+	}
+
+	template <typename L, typename R>
+	auto dot(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return sum(l * r); }
+
+	template <typename E>
+	bool all(const ArrayExpr<E>& mask) { return reduce<And>(mask.self(), true); }
+
+	template <typename E>
+	bool any(const ArrayExpr<E>& mask) { return reduce<Or>(mask.self(), false); }
+}
+
+template <typename T, int size, size_t alignment = static_array_expr::simd_alignment> // size is an integral non-type parameter
+class StaticArray : public static_array_expr::ArrayExpr<StaticArray<T, size, alignment>>
 {
 private:
+	static_assert(alignment >= alignof(T) && (alignment & (alignment - 1)) == 0, "The alignment must be a power of two, at least alignof(T)");
+
 	// The non-type parameter controls the size of the array
-	T m_array[size]{};
+	alignas(alignment) T m_array[size];
+
+	template <typename E>
+	void assign(const E& expr) {
+		static_assert(E::length == size || E::length == 0, "The arrays must have the same length");
+		T* out = std::assume_aligned<alignment>(m_array);
+		for (int i = 0; i < size; ++i) out[i] = static_cast<T>(expr[i]);
+	}
 
 public:
+	using value_type = T;
+	static constexpr int length = size;
+	static constexpr bool is_terminal = true;
+
+	StaticArray() : m_array{} {}
+	explicit StaticArray(static_array_expr::Uninitialized) {}
+	explicit StaticArray(const T& value) { assign(static_array_expr::Scalar<T>{ value }); }
+	StaticArray(std::initializer_list<T> values) : m_array{} {
+		int i = 0;
+		for (auto it = values.begin(); it != values.end() && i < size; ++it) m_array[i++] = *it;
+	}
+
+	//Evaluates the expression, a = b + c * d is a single loop.
+	template <typename E>
+	StaticArray(const static_array_expr::ArrayExpr<E>& expr) { assign(expr.self()); }
+
+	template <typename E>
+	StaticArray& operator=(const static_array_expr::ArrayExpr<E>& expr) {
+		assign(expr.self());	//Element i only reads index i of the operands, so a = a + b is safe
+		return *this;
+	}
+
+	template <typename E>
+	StaticArray& operator+=(const static_array_expr::ArrayExpr<E>& expr) { return *this = *this + expr; }
+	template <typename E>
+	StaticArray& operator-=(const static_array_expr::ArrayExpr<E>& expr) { return *this = *this - expr; }
+	template <typename E>
+	StaticArray& operator*=(const static_array_expr::ArrayExpr<E>& expr) { return *this = *this * expr; }
+	template <typename E>
+	StaticArray& operator/=(const static_array_expr::ArrayExpr<E>& expr) { return *this = *this / expr; }
+	StaticArray& operator+=(const T& value) { return *this = *this + value; }
+	StaticArray& operator-=(const T& value) { return *this = *this - value; }
+	StaticArray& operator*=(const T& value) { return *this = *this * value; }
+	StaticArray& operator/=(const T& value) { return *this = *this / value; }
+
 	T* getArray();
+	T* data() { return m_array; }
+	const T* data() const { return m_array; }
+	T* begin() { return m_array; }
+	T* end() { return m_array + size; }
+	const T* begin() const { return m_array; }
+	const T* end() const { return m_array + size; }
 
 	T& operator[](int index)
 	{
 		return m_array[index];
 	}
+
+	const T& operator[](int index) const
+	{
+		return m_array[index];
+	}
 };
 // Showing how a function for a class with a non-type parameter is defined outside of the class
-template <typename T, int size>
-T* StaticArray<T, size>::getArray()
+template <typename T, int size, size_t alignment>
+T* StaticArray<T, size, alignment>::getArray()
 {
 	return m_array;
 }
@@ -83,8 +314,52 @@ int runnerStaticArray()
 	return 0;
 }
 
+//The same computations with a StaticArray expression, a hand written loop and std::valarray (which uses expression templates as well,
+//but its size is only known at runtime and its storage is not aligned).
+void runnerStaticArrayBenchmark()
+{
+	constexpr int length = 1024;	//4 KiB per array, all operands stay in L1
+	const int rounds = 200000;
+	StaticArray<float, length> a, b, c, r;
+	std::valarray<float> va(length), vb(length), vc(length), vr(length);
+	float pa[length], pb[length], pc[length], pr[length];
+	for (int i = 0; i < length; ++i) {
+		a[i] = va[i] = pa[i] = 1.0f + static_cast<float>(i % 7);
+		b[i] = vb[i] = pb[i] = 0.5f + static_cast<float>(i % 5);
+		c[i] = vc[i] = pc[i] = 2.0f - static_cast<float>(i % 3);
+	}
+
+	//Each round changes one input, otherwise the compiler could compute the (loop invariant) result only once.
+	auto measure = [&](const char* label, auto&& body) {
+		float checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; ++round) checksum += body(round % length);
+		auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double(rounds) * length);
+		std::cout << label << ns << " ns per element (checksum " << checksum << ")" << std::endl;
+	};
+
+	std::cout << "r = a + b * c" << std::endl;
+	measure("  StaticArray expression: ", [&](int i) { a[i] += 1.0f; r = a + b * c; return r[i]; });
+	measure("  Hand written loop:      ", [&](int i) { pa[i] += 1.0f; for (int j = 0; j < length; ++j) pr[j] = pa[j] + pb[j] * pc[j]; return pr[i]; });
+	measure("  std::valarray:          ", [&](int i) { va[i] += 1.0f; vr = va + vb * vc; return vr[i]; });
+
+	std::cout << "dot(a, b)" << std::endl;
+	measure("  StaticArray dot:        ", [&](int i) { a[i] += 1.0f; return dot(a, b); });
+	measure("  Hand written loop:      ", [&](int i) { pa[i] += 1.0f; float s = 0; for (int j = 0; j < length; ++j) s += pa[j] * pb[j]; return s; });
+	measure("  std::valarray:          ", [&](int i) { va[i] += 1.0f; return (va * vb).sum(); });
+
+	std::cout << "max(a - c)" << std::endl;
+	measure("  StaticArray max:        ", [&](int i) { a[i] -= 1.0f; return max(a - c); });
+	measure("  Hand written loop:      ", [&](int i) { pa[i] -= 1.0f; float m = pa[0] - pc[0]; for (int j = 1; j < length; ++j) m = std::max(m, pa[j] - pc[j]); return m; });
+	measure("  std::valarray:          ", [&](int i) { va[i] -= 1.0f; return std::valarray<float>(va - vc).max(); });
+
+	StaticArray<bool, length> positive = a > 0.0f;
+	std::cout << "all(a > 0): " << all(positive) << ", any(b == c): " << any(b == c) << ", sum(muladd(a, b, c)): " << sum(muladd(a, b, c)) << std::endl;
+}
+
 //*******************************************************************************************************************************************************
 //****************************************************** Stopping implicit conversion ************************************************
+//The same for whole ranges of numbers (min, max, argmin, clamp, ... with SIMD): templates_minmax.h
 template <class T>				//Templates don't allow implicit conversions, hence we can avoid it by defining a template for the function.
 T min(T a, T b) {
 	return a < b ? a : b;
@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+//C++ can't list the enumerators of an enum, so every enum used to get its own hand written switch in operator<< (some of them writing to
+//std::cout instead of the stream, some flushing with std::endl). Here the names are declared once, next to the enum, as a constexpr table:
+//	enum class Color { red, green, blue };
+//	constexpr std::array<std::string_view, 3> enum_names(Color) { return { "Red", "Green", "Blue" }; }	//Found through ADL
+//The enumerators must be 0, 1, 2, ... in the order of the table. Everything else is generated at compile time from the table:
+//	to_string_view(e)	- an array index, no branches.
+//	from_string<E>(s)	- a perfect hash of the table (a hash function without collisions for these names, found by the compiler),
+//						  one hash, one compare. Case insensitive, "red", "Red" and "RED" all parse.
+//	write(os, e)		- the name with ostream::write, no flush; append(out, e) into a std::string.
+
+namespace templates_enum_reflection {
+	template <typename E>
+	inline constexpr auto names_of = enum_names(E{});
+
+	template <typename E>
+	inline constexpr size_t count_of = names_of<E>.size();
+
+	template <typename E>
+	constexpr std::string_view to_string_view(E value) {
+		static_assert(std::is_enum_v<E>, "Only enums have names");
+		const auto index = static_cast<size_t>(value);
+		return index < count_of<E> ? names_of<E>[index] : std::string_view{};
+	}
+
+	constexpr char fold_case(char c) {
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+	}
+
+	constexpr std::uint32_t hash(std::string_view text, std::uint32_t seed) {
+		std::uint32_t h = 2166136261u ^ seed;	//FNV-1a
+		for (char c : text) {
+			h ^= static_cast<unsigned char>(fold_case(c));
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	constexpr bool equal_ignore_case(std::string_view a, std::string_view b) {
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (fold_case(a[i]) != fold_case(b[i])) return false;
+		}
+		return true;
+	}
+
+	template <size_t Count>
+	struct PerfectHash {
+		static constexpr size_t slot_count = [] {
+			size_t n = 1;
+			while (n < 2 * Count) n *= 2;
+			return n;
+		}();
+
+		std::uint32_t seed{ 0 };
+		std::array<std::uint8_t, slot_count> slots{};	//Enumerator + 1, 0 for an empty slot
+
+		//Tries seeds until every name lands in its own slot. Runs in the compiler, the table is a constant.
+		constexpr explicit PerfectHash(const std::array<std::string_view, Count>& names) {
+			static_assert(Count < 255, "Too many enumerators for a one byte slot");
+			for (; seed < 100000; ++seed) {
+				slots = {};
+				bool collision = false;
+				for (size_t i = 0; i < Count && !collision; ++i) {
+					auto& slot = slots[hash(names[i], seed) & (slot_count - 1)];
+					collision = slot != 0;
+					slot = static_cast<std::uint8_t>(i + 1);
+				}
+				if (!collision) return;
+			}
+			throw "No perfect hash found, the enum has duplicate names";
+		}
+	};
+
+	template <typename E>
+	inline constexpr PerfectHash<count_of<E>> perfect_hash_of{ names_of<E> };
+
+	template <typename E>
+	constexpr std::optional<E> from_string(std::string_view text) {
+		constexpr auto& table = perfect_hash_of<E>;
+		const auto slot = table.slots[hash(text, table.seed) & (table.slot_count - 1)];
+		if (slot == 0 || !equal_ignore_case(text, names_of<E>[slot - 1])) return std::nullopt;
+		return static_cast<E>(slot - 1);
+	}
+
+	template <typename E>
+	std::ostream& write(std::ostream& os, E value) {
+		const auto name = to_string_view(value);
+		return os.write(name.data(), static_cast<std::streamsize>(name.size()));
+	}
+
+	template <typename E>
+	void append(std::string& out, E value) {
+		out += to_string_view(value);
+	}
+}
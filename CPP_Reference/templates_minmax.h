@@ -0,0 +1,373 @@
+#pragma once
+#include <bit>
+#include <span>
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <future>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <string_view>
+#include "concurrency_thread_pool.h"
+#include "templates_enum_reflection.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEMPLATES_MINMAX_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+//min(T a, T b) of templates_basics.h for whole ranges of numbers (any contiguous range: std::vector, std::array, C arrays, spans):
+//	min, max, minmax		- the values.
+//	argmin, argmax			- the index of the first smallest/largest element, values.size() if there is none.
+//	min_element, max_element- the same as a pointer (end of the range if there is none), like std::min_element.
+//	clamp					- every element into [lo, hi], in place.
+//std::min_element compares one element at a time and has to remember where the minimum is, it runs at a fraction of the memory
+//bandwidth. Here the loops work on whole SIMD registers (SSE2, or AVX2 if the CPU has it, checked once at runtime) for float, double
+//and 32 bit integers. argmin/argmax first find the value and then search its first position, which is faster than tracking
+//indices in every step. Other types use the same kernels with one element per "register".
+//NaN: NaNs are skipped (like std::fmin/std::fmax), min/max of a range with only NaNs is NaN, argmin/argmax of it is values.size().
+//std::min_element instead depends on where the NaN is: a NaN in the first position is returned, anywhere else it is skipped.
+//clamp leaves NaNs as they are, like std::clamp.
+//Execution::parallel splits ranges of at least parallel_threshold elements over concurrency_thread_pool::ThreadPool::shared().
+
+namespace templates_minmax {
+	enum class Execution { sequential, parallel };
+	constexpr std::array<std::string_view, 2> enum_names(Execution) { return { "sequential", "parallel" }; }
+	std::ostream& operator<<(std::ostream& os, Execution execution) {
+		return templates_enum_reflection::write(os, execution);
+	}
+
+	inline constexpr size_t parallel_threshold = size_t{ 1 } << 20;
+
+	template <typename T>
+	struct MinMax {
+		T min;
+		T max;
+	};
+
+	namespace detail {
+		namespace scalar {
+			template <typename T>
+			struct Vec {
+				using reg = T;
+				static constexpr size_t width = 1;
+				static T load(const T* p) { return *p; }
+				static void store(T* p, T r) { *p = r; }
+				static T set1(T x) { return x; }
+				static T min(T a, T b) { return a < b ? a : b; }
+				static T max(T a, T b) { return a > b ? a : b; }
+				static unsigned equal_mask(T a, T b) { return a == b; }
+			};
+
+#include "templates_minmax_kernels.inl"
+		}
+
+#if defined(TEMPLATES_MINMAX_X86)
+		namespace sse2 {
+			template <typename T>
+			struct Vec;
+
+			template <>
+			struct Vec<float> {
+				using reg = __m128;
+				static constexpr size_t width = 4;
+				static reg load(const float* p) { return _mm_loadu_ps(p); }
+				static void store(float* p, reg r) { _mm_storeu_ps(p, r); }
+				static reg set1(float x) { return _mm_set1_ps(x); }
+				static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+				static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+			};
+
+			template <>
+			struct Vec<double> {
+				using reg = __m128d;
+				static constexpr size_t width = 2;
+				static reg load(const double* p) { return _mm_loadu_pd(p); }
+				static void store(double* p, reg r) { _mm_storeu_pd(p, r); }
+				static reg set1(double x) { return _mm_set1_pd(x); }
+				static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+				static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(a, b))); }
+			};
+
+			//SSE2 has no 32 bit integer min/max (SSE4.1 added them), compare and select instead.
+			template <>
+			struct Vec<std::int32_t> {
+				using reg = __m128i;
+				static constexpr size_t width = 4;
+				static reg load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+				static void store(std::int32_t* p, reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+				static reg set1(std::int32_t x) { return _mm_set1_epi32(x); }
+				static reg select(reg mask, reg a, reg b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+				static reg min(reg a, reg b) { return select(_mm_cmplt_epi32(a, b), a, b); }
+				static reg max(reg a, reg b) { return select(_mm_cmpgt_epi32(a, b), a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))); }
+			};
+
+#include "templates_minmax_kernels.inl"
+		}
+
+		//Everything up to the pop is compiled for AVX2 (GCC and Clang need that for the intrinsics, MSVC always accepts them) and only
+		//called after the CPU was checked.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+		namespace avx2 {
+			template <typename T>
+			struct Vec;
+
+			template <>
+			struct Vec<float> {
+				using reg = __m256;
+				static constexpr size_t width = 8;
+				static reg load(const float* p) { return _mm256_loadu_ps(p); }
+				static void store(float* p, reg r) { _mm256_storeu_ps(p, r); }
+				static reg set1(float x) { return _mm256_set1_ps(x); }
+				static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+				static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+			};
+
+			template <>
+			struct Vec<double> {
+				using reg = __m256d;
+				static constexpr size_t width = 4;
+				static reg load(const double* p) { return _mm256_loadu_pd(p); }
+				static void store(double* p, reg r) { _mm256_storeu_pd(p, r); }
+				static reg set1(double x) { return _mm256_set1_pd(x); }
+				static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+				static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+			};
+
+			template <>
+			struct Vec<std::int32_t> {
+				using reg = __m256i;
+				static constexpr size_t width = 8;
+				static reg load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+				static void store(std::int32_t* p, reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+				static reg set1(std::int32_t x) { return _mm256_set1_epi32(x); }
+				static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+				static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+				static unsigned equal_mask(reg a, reg b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))); }
+			};
+
+#include "templates_minmax_kernels.inl"
+		}
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+		//AVX2 needs the CPU to have it and the operating system to save the 256 bit registers.
+		inline bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+
+		inline const bool has_avx2 = cpu_has_avx2();
+#endif
+
+		template <typename T>
+		inline constexpr bool has_simd_kernels = std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, std::int32_t>;
+
+		//The kernels for T on this CPU.
+		template <typename T>
+		MinMax<T> minmax(const T* p, size_t n) {
+#if defined(TEMPLATES_MINMAX_X86)
+			if constexpr (has_simd_kernels<T>) {
+				if (has_avx2) return avx2::minmax_kernel(p, n);
+				return sse2::minmax_kernel(p, n);
+			}
+#endif
+			return scalar::minmax_kernel(p, n);
+		}
+
+		template <typename T>
+		size_t find(const T* p, size_t n, T value) {
+#if defined(TEMPLATES_MINMAX_X86)
+			if constexpr (has_simd_kernels<T>) {
+				if (has_avx2) return avx2::find_kernel(p, n, value);
+				return sse2::find_kernel(p, n, value);
+			}
+#endif
+			return scalar::find_kernel(p, n, value);
+		}
+
+		template <typename T>
+		void clamp(T* p, size_t n, T lo, T hi) {
+#if defined(TEMPLATES_MINMAX_X86)
+			if constexpr (has_simd_kernels<T>) {
+				if (has_avx2) return avx2::clamp_kernel(p, n, lo, hi);
+				return sse2::clamp_kernel(p, n, lo, hi);
+			}
+#endif
+			scalar::clamp_kernel(p, n, lo, hi);
+		}
+
+		//Calls chunk(begin, end) for consecutive pieces of [0, n), on the pool if the range is big enough, and returns the results in order.
+		template <typename F>
+		auto for_chunks(size_t n, Execution execution, F chunk) -> std::vector<decltype(chunk(size_t{}, size_t{}))> {
+			using R = decltype(chunk(size_t{}, size_t{}));
+			if (execution == Execution::sequential || n < parallel_threshold) return { chunk(0, n) };
+
+			auto& pool = concurrency_thread_pool::ThreadPool::shared();
+			const size_t count = std::min(pool.size() + 1, n / (parallel_threshold / 16));
+			const size_t step = (n + count - 1) / count;
+			std::vector<std::future<R>> pending;
+			for (size_t begin = step; begin < n; begin += step) pending.push_back(pool.submit(chunk, begin, std::min(begin + step, n)));
+			std::vector<R> results{ chunk(0, step) };	//The calling thread takes the first piece
+			for (auto& result : pending) results.push_back(pool.wait(result));
+			return results;
+		}
+
+		template <typename T>
+		MinMax<T> minmax(std::span<const T> values, Execution execution) {
+			auto parts = for_chunks(values.size(), execution, [p = values.data()](size_t begin, size_t end) { return minmax(p + begin, end - begin); });
+			MinMax<T> result = parts[0];
+			for (const auto& part : parts) {
+				if (part.min < result.min) result.min = part.min;
+				if (part.max > result.max) result.max = part.max;
+			}
+			return result;
+		}
+
+		//Position of the first element equal to the smallest (Largest = false) or largest value, values.size() if there is none.
+		template <bool Largest, typename T>
+		size_t arg_extreme(std::span<const T> values, Execution execution) {
+			const T* p = values.data();
+			const size_t none = values.size();
+			auto parts = for_chunks(values.size(), execution, [p, none](size_t begin, size_t end) {
+				const auto range = minmax(p + begin, end - begin);
+				if (!(range.min <= range.max)) return std::pair<T, size_t>{ T{}, none };	//Only NaNs in this piece
+				const T target = Largest ? range.max : range.min;
+				return std::pair<T, size_t>{ target, begin + find(p + begin, end - begin, target) };
+			});
+			//The pieces are in order and only a strictly better value replaces the best, so on equal values the first one wins.
+			size_t best = none;
+			for (const auto& [value, index] : parts) {
+				if (index == none) continue;
+				if (best == none || (Largest ? p[best] < value : value < p[best])) best = index;
+			}
+			return best;
+		}
+	}
+
+	template <typename R>
+	using element_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::data(std::declval<R&>()))>>;
+
+	template <typename R>
+	MinMax<element_t<R>> minmax(const R& values, Execution execution = Execution::sequential) {
+		using T = element_t<R>;
+		static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "minmax needs a range of numbers");
+		const std::span<const T> view{ std::data(values), std::size(values) };
+		if (view.empty()) throw std::invalid_argument("minmax of an empty range");
+		auto result = detail::minmax(view, execution);
+		if (!(result.min <= result.max)) result.min = result.max = std::numeric_limits<T>::quiet_NaN();	//Only NaNs
+		return result;
+	}
+
+	template <typename R>
+	element_t<R> min(const R& values, Execution execution = Execution::sequential) { return minmax(values, execution).min; }
+
+	template <typename R>
+	element_t<R> max(const R& values, Execution execution = Execution::sequential) { return minmax(values, execution).max; }
+
+	template <typename R>
+	size_t argmin(const R& values, Execution execution = Execution::sequential) {
+		using T = element_t<R>;
+		static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "argmin needs a range of numbers");
+		return detail::arg_extreme<false>(std::span<const T>{ std::data(values), std::size(values) }, execution);
+	}
+
+	template <typename R>
+	size_t argmax(const R& values, Execution execution = Execution::sequential) {
+		using T = element_t<R>;
+		static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "argmax needs a range of numbers");
+		return detail::arg_extreme<true>(std::span<const T>{ std::data(values), std::size(values) }, execution);
+	}
+
+	template <typename R>
+	const element_t<R>* min_element(const R& values, Execution execution = Execution::sequential) {
+		return std::data(values) + argmin(values, execution);
+	}
+
+	template <typename R>
+	const element_t<R>* max_element(const R& values, Execution execution = Execution::sequential) {
+		return std::data(values) + argmax(values, execution);
+	}
+
+	template <typename R>
+	void clamp(R& values, element_t<R> lo, element_t<R> hi, Execution execution = Execution::sequential) {
+		using T = element_t<R>;
+		static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "clamp needs a range of numbers");
+		if (hi < lo) throw std::invalid_argument("clamp with hi < lo");
+		T* p = std::data(values);
+		detail::for_chunks(std::size(values), execution, [=](size_t begin, size_t end) {
+			detail::clamp(p + begin, end - begin, lo, hi);
+			return true;
+		});
+	}
+
+	void main() {
+		const size_t count = size_t{ 1 } << 24;	//64 MiB of floats, far bigger than the caches: the memory bandwidth is the limit
+		std::vector<float> telemetry(count);
+		std::mt19937 rng{ 5 };
+		std::normal_distribution<float> noise{ 20.0f, 5.0f };
+		for (auto& value : telemetry) value = noise(rng);
+		telemetry[count / 3] = -40.0f;
+		telemetry[count / 2] = std::numeric_limits<float>::quiet_NaN();	//A broken sensor reading
+
+		auto measure = [&](const std::string& label, auto&& body) {
+			const int rounds = 5;
+			size_t result = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < rounds; ++r) result += body();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / rounds;
+			std::cout << label << seconds * 1000 << " ms, " << count * sizeof(float) / seconds / 1e9 << " GB/s (index " << result / rounds << ")" << std::endl;
+		};
+		measure("std::min_element:         ", [&] { return static_cast<size_t>(std::min_element(telemetry.begin(), telemetry.end()) - telemetry.begin()); });
+		for (auto execution : { Execution::sequential, Execution::parallel }) {
+			const std::string label = "argmin, " + std::string{ templates_enum_reflection::to_string_view(execution) } + ":";
+			measure(label + std::string(26 - label.size(), ' '), [&] { return argmin(telemetry, execution); });
+		}
+		measure("minmax:                   ", [&] { return static_cast<size_t>(minmax(telemetry).max); });
+
+		const auto [low, high] = minmax(telemetry);
+		std::cout << "min " << low << " at " << argmin(telemetry) << ", max " << high << " at " << argmax(telemetry)
+			<< std::endl;
+
+		clamp(telemetry, 0.0f, 40.0f, Execution::parallel);
+		std::cout << "After clamp to [0, 40] (" << Execution::parallel << "): min " << min(telemetry) << ", max " << max(telemetry)
+			<< ", the NaN is still there: " << std::isnan(telemetry[count / 2]) << std::endl;
+
+		const int readings[] = { 7, -3, 12, -3, 9 };
+		std::cout << "int: argmin " << argmin(readings) << ", argmax " << argmax(readings) << ", *min_element " << *min_element(readings) << std::endl;
+	}
+}
@@ -0,0 +1,68 @@
+//The kernels of templates_minmax.h, written once against a Vec<T> that describes the SIMD registers of one instruction set:
+//	reg, width, load(p), store(p, r), set1(x), min(a, b), max(a, b) (both return b if a lane of a or b is a NaN), equal_mask(a, b).
+//The file is included inside every namespace that defines such a Vec (scalar, sse2, avx2), so each instruction set gets its own copy,
+//compiled for its target. Only include it from templates_minmax.h.
+
+	//NaNs never win a comparison and are skipped. If there is no number at all, the result is min > max.
+	template <typename T>
+	MinMax<T> minmax_kernel(const T* p, size_t n) {
+		using V = Vec<T>;
+		constexpr size_t W = V::width;
+		const T highest = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+		const T lowest = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+		//Two pairs of accumulators, so consecutive iterations don't wait for each other.
+		auto lo0 = V::set1(highest), lo1 = lo0;
+		auto hi0 = V::set1(lowest), hi1 = hi0;
+		size_t i = 0;
+		for (; i + 2 * W <= n; i += 2 * W) {
+			const auto a = V::load(p + i);
+			const auto b = V::load(p + i + W);
+			lo0 = V::min(a, lo0);
+			lo1 = V::min(b, lo1);
+			hi0 = V::max(a, hi0);
+			hi1 = V::max(b, hi1);
+		}
+		T lanes_lo[2 * W], lanes_hi[2 * W];
+		V::store(lanes_lo, lo0);
+		V::store(lanes_lo + W, lo1);
+		V::store(lanes_hi, hi0);
+		V::store(lanes_hi + W, hi1);
+		MinMax<T> result{ highest, lowest };
+		for (size_t l = 0; l < 2 * W; ++l) {
+			if (lanes_lo[l] < result.min) result.min = lanes_lo[l];
+			if (lanes_hi[l] > result.max) result.max = lanes_hi[l];
+		}
+		for (; i < n; ++i) {
+			if (p[i] < result.min) result.min = p[i];
+			if (p[i] > result.max) result.max = p[i];
+		}
+		return result;
+	}
+
+	//Index of the first element equal to value, n if there is none. Stops at the first block with a match.
+	template <typename T>
+	size_t find_kernel(const T* p, size_t n, T value) {
+		using V = Vec<T>;
+		constexpr size_t W = V::width;
+		const auto target = V::set1(value);
+		size_t i = 0;
+		for (; i + W <= n; i += W) {
+			if (const unsigned mask = V::equal_mask(V::load(p + i), target)) return i + static_cast<size_t>(std::countr_zero(mask));
+		}
+		for (; i < n; ++i) {
+			if (p[i] == value) return i;
+		}
+		return n;
+	}
+
+	//max(lo, x) and min(hi, x) return x when x is a NaN, so NaNs stay NaNs like with std::clamp.
+	template <typename T>
+	void clamp_kernel(T* p, size_t n, T lo, T hi) {
+		using V = Vec<T>;
+		constexpr size_t W = V::width;
+		const auto low = V::set1(lo);
+		const auto high = V::set1(hi);
+		size_t i = 0;
+		for (; i + W <= n; i += W) V::store(p + i, V::min(high, V::max(low, V::load(p + i))));
+		for (; i < n; ++i) p[i] = p[i] < lo ? lo : hi < p[i] ? hi : p[i];
+	}
@@ -1,5 +1,12 @@
 #pragma once
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <utility>
 #include <iostream>
+#include <functional>
 
 //*******************************************************************************************************************************************************
 //****************************************************** Templates Specialization ************************************************
@@ -9,6 +16,7 @@ bool equal(const T& val1, const T& val2) {
 }
 
 //Template specialization
+//Comparing whole arrays, with absolute, relative or ulp tolerances chosen by specialization: templates_approx_equal.h
 template <>
 bool equal(const double& a, const double& b) {
 	return std::abs(a - b) < 0.00001;
@@ -47,32 +55,116 @@ namespace template_specialization_example_2 {
 		}
 	};
 
+	//A member specialization (of the constructor and destructor, as learncpp does) can't add members, so Storage<char*> had no copy and
+	//move constructors: a copy shared the pointer and both copies deleted it. The whole class is specialized instead, into a small
+	//owning string:
+	//	- Strings of up to inline_capacity characters are stored in the object itself (small string optimization), no allocation.
+	//	- Longer ones go to the heap. Length and copy use strlen/memcpy, which the C library implements with SIMD.
+	//	- A copy owns a copy of the characters. A move steals the heap buffer (or copies the few inline bytes) and leaves the source empty.
 	template <>
-	Storage<char*>::Storage(char* value)
+	class Storage<char*>
 	{
-		std::cout << "Spcialization constructor running" << std::endl;
-		if (!value)
-			return;
-
-		// Figure out how long the string in value is
-		int length{ 0 };
-		while (value[length] != '\0')
-			++length;
-		++length; // +1 to account for null terminator
-
-		// Allocate memory to hold the value string
-		m_value = new char[length];
-
-		// Copy the actual value string into the m_value memory we just allocated
-		for (int count = 0; count < length; ++count)
-			m_value[count] = value[count];
-	}
+	public:
+		static constexpr size_t inline_capacity = 23;	//Characters, without the terminator
 
-	template <>
-	Storage<char*>::~Storage()	// ########### Destructor specialization ##########
-	{
-		delete[] m_value;
-	}
+	private:
+		char* m_value{ m_small };	//m_small or a heap buffer
+		size_t m_length{ 0 };
+		union {
+			char m_small[inline_capacity + 1];
+			size_t m_capacity;	//Of the heap buffer, when it is used
+		};
+
+		bool is_small() const { return m_value == m_small; }
+
+		//Copies length characters into a buffer that is big enough, this storage is empty.
+		void init(const char* value, size_t length) {
+			if (length > inline_capacity) {
+				m_value = new char[length + 1];
+				m_capacity = length;
+			}
+			std::memcpy(m_value, value, length);
+			m_value[length] = '\0';
+			m_length = length;
+		}
+
+		void release() {
+			if (!is_small()) delete[] m_value;
+			m_value = m_small;
+			m_small[0] = '\0';
+			m_length = 0;
+		}
+
+		//Takes the characters of other, which is left empty.
+		void steal(Storage& other) noexcept {
+			if (other.is_small()) {
+				std::memcpy(m_small, other.m_small, other.m_length + 1);
+				m_value = m_small;
+			}
+			else {
+				m_value = other.m_value;
+				m_capacity = other.m_capacity;
+				other.m_value = other.m_small;
+			}
+			m_length = other.m_length;
+			other.m_small[0] = '\0';
+			other.m_length = 0;
+		}
+
+	public:
+		Storage(const char* value)
+			: m_small{}
+		{
+			if (value)
+				init(value, std::strlen(value));
+		}
+
+		Storage(const Storage& other)
+			: m_small{}
+		{
+			init(other.m_value, other.m_length);
+		}
+
+		Storage(Storage&& other) noexcept
+			: m_small{}
+		{
+			steal(other);
+		}
+
+		Storage& operator=(const Storage& other) {
+			if (this == &other)
+				return *this;
+			if (!is_small() && other.m_length <= m_capacity) {	//Reuse the heap buffer
+				std::memcpy(m_value, other.m_value, other.m_length + 1);
+				m_length = other.m_length;
+				return *this;
+			}
+			release();
+			init(other.m_value, other.m_length);
+			return *this;
+		}
+
+		Storage& operator=(Storage&& other) noexcept {
+			if (this != &other) {
+				release();
+				steal(other);
+			}
+			return *this;
+		}
+
+		~Storage() {
+			if (!is_small()) delete[] m_value;
+		}
+
+		const char* c_str() const { return m_value; }
+		size_t size() const { return m_length; }
+		bool is_inline() const { return is_small(); }
+
+		void print()
+		{
+			std::cout << m_value << '\n';
+		}
+	};
 
 	int runnerStorage()
 	{
@@ -82,7 +174,7 @@ namespace template_specialization_example_2 {
 
 		// Ask user for their name
 		std::cout << "Enter your name: ";
-		std::cin >> s;
+		std::cin.getline(s, 40);	//operator>>(istream&, char*) was removed in C++20, it couldn't know the size of the buffer
 
 		// Store the name
 		Storage<char*> storage(s);
@@ -94,6 +186,49 @@ namespace template_specialization_example_2 {
 		storage.print(); // Prints our name
 		return 0;
 	}
+
+	//Construct, copy and move Storage<char*> against std::string, for short (inline in both) and long (heap) strings.
+	void runnerStorageBenchmark()
+	{
+		const int count = 1000000;
+		auto run = [&](const char* label, size_t length) {
+			std::vector<std::string> sources;
+			sources.reserve(count);
+			for (int i = 0; i < count; ++i) sources.push_back(std::string(length, static_cast<char>('a' + i % 26)));
+
+			auto measure = [&](auto tag, bool report) {
+				using S = decltype(tag);
+				size_t checksum = 0;
+				auto start = std::chrono::steady_clock::now();
+				std::vector<S> constructed;
+				constructed.reserve(count);
+				for (const auto& source : sources) constructed.emplace_back(source.c_str());
+				auto construct_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+				start = std::chrono::steady_clock::now();
+				std::vector<S> copies{ constructed };
+				auto copy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+				start = std::chrono::steady_clock::now();
+				std::vector<S> moved;
+				moved.reserve(count);
+				for (auto& value : copies) moved.push_back(std::move(value));
+				auto move_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+				for (const auto& value : moved) checksum += value.size();
+				if (report) std::cout << "construct " << construct_ns << " ns, copy " << copy_ns << " ns, move " << move_ns << " ns (" << checksum << " chars)" << std::endl;
+			};
+			//A first round of both only warms up the allocator, fresh memory from the OS page faults on first use.
+			measure(Storage<char*>{ "" }, false);
+			measure(std::string{}, false);
+			std::cout << label << " Storage<char*>: ";
+			measure(Storage<char*>{ "" }, true);
+			std::cout << label << " std::string:    ";
+			measure(std::string{}, true);
+		};
+		run("10 characters: ", 10);
+		run("100 characters:", 100);
+	}
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~ Example 3, Template Specilization to take a function as parameter (Taken from function decorator) ~~~~~~~~~~~~~~~~~~~~~~
@@ -5,22 +5,30 @@
 #include <iostream>
 #include <functional>
 #include <type_traits>
+#include "dp_decorator_render.h"
 
 namespace temp_testing {
+	using dp_decorator_render::append;
 
 	class Shape {
 	public:
-		virtual std::string str() const noexcept = 0;
+		virtual void render(std::string& out) const noexcept = 0;
+
+		std::string str() const noexcept {
+			std::string out;
+			render(out);
+			return out;
+		}
 	};
 
 	class Circle : public Shape {
 	public:
 		float radius;
 		Circle(float r) :radius{ r } {}
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The Circle has radius of " << radius << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			append(out, "The Circle has radius of ");
+			append(out, radius);
+			out += '\n';
 		}
 
 		void resize(float scale) { radius *= scale; }
@@ -30,10 +38,10 @@ namespace temp_testing {
 	public:
 		float side;
 		Square(float s) :side{ s } {}
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << "The square has a side length " << side << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			append(out, "The square has a side length ");
+			append(out, side);
+			out += '\n';
 		}
 	};
 
@@ -43,22 +51,22 @@ namespace temp_testing {
 	public:
 		TransDec(Shape& s, float t) : shp{ s }, transparancy(t){}
 
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << shp.str()
-				<< "The transprancy level is " << transparancy << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			shp.render(out);
+			append(out, "The transprancy level is ");
+			append(out, transparancy);
+			out += '\n';
 		}
 	};
 
 	class ColorDec : public Shape {
 	public:
 		ColorDec(Shape& s, const std::string& c) : shp(s), shp_color{ c } {}
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << shp.str()
-				<< "and has color " << shp_color << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			shp.render(out);
+			append(out, "and has color ");
+			append(out, shp_color);
+			out += '\n';
 		}
 
 	private:
@@ -74,10 +82,11 @@ namespace temp_testing {
 		ColorDecorator(std::string c, Args ...args) :
 			color{ c }, T{ std::forward<Args>(args)... }{}
 
-		std::string str() const noexcept override{
-			std::ostringstream oss;
-			oss << T::str() << "The Color is " << color << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			T::render(out);
+			append(out, "The Color is ");
+			append(out, color);
+			out += '\n';
 		}
 	};
 
@@ -88,10 +97,11 @@ namespace temp_testing {
 		template <typename... Args>
 		TransparancyDecorator(float t, Args... args):
 			transparancy{ t }, T{ std::forward<Args>(args)...}{}
-		std::string str() const noexcept override {
-			std::ostringstream oss;
-			oss << T::str() << "Transparancy is " << transparancy << std::endl;
-			return oss.str();
+		void render(std::string& out) const noexcept override {
+			T::render(out);
+			append(out, "Transparancy is ");
+			append(out, transparancy);
+			out += '\n';
 		}
 	};
 